@@ -0,0 +1,92 @@
+#ifndef CRITICALITYMASKS_H_
+#define CRITICALITYMASKS_H_
+
+#include "SquareMatrix.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * For a set of candidate clock periods, it tells which pairs of nodes are
+ * critical, i.e. have D(i,j) greater than the period.
+ * There is one bitset of side * side bits for each distinct period, packed
+ * in 64 bit words row by row, so that k periods cost k bits per pair instead
+ * of k pC matrices.
+ */
+class CriticalityMasks {
+public:
+	/**
+	 * build the masks of the given periods with a single pass over D
+	 * @param d the D matrix
+	 * @param periods the candidate clock periods, in any order and possibly
+	 *                repeated
+	 */
+	CriticalityMasks(const SquareMatrix &d, const std::vector<int> &periods);
+
+	/**
+	 * get the number of distinct periods
+	 * @return the number of masks
+	 */
+	unsigned int get_num_periods() const;
+
+	/**
+	 * get the index of the mask of a period
+	 * @param period one of the periods given to the constructor
+	 * @return the index of its mask, periods are sorted in increasing order
+	 */
+	unsigned int get_index(int period) const;
+
+	/**
+	 * compute a row of pC for the period of mask k: PC(i,j) is W(i,j) minus
+	 * one if the pair is critical, else W(i,j). Only the set bits of the
+	 * row are visited.
+	 * @param k the index of the mask
+	 * @param i row index
+	 * @param w_row the row i of W
+	 * @param pc_row the row i of pC that is written
+	 */
+	void build_pc_row(unsigned int k, unsigned int i, const int *w_row,
+			int *pc_row) const;
+
+	/**
+	 * count the critical pairs of the whole matrix
+	 * @param k the index of the mask
+	 * @return the number of critical pairs
+	 */
+	unsigned long count_critical(unsigned int k) const;
+
+	/**
+	 * count the pairs that are critical for period k but not for period l
+	 * (for l > k they are the pairs that the longer period relaxes)
+	 * @param k the index of the first mask
+	 * @param l the index of the second mask
+	 * @return the number of pairs critical in k and not in l
+	 */
+	unsigned long count_difference(unsigned int k, unsigned int l) const;
+
+private:
+	/**
+	 * get the first word of row i of mask k, the rows of a mask are
+	 * contiguous
+	 */
+	const uint64_t *row(unsigned int k, unsigned int i) const;
+
+	/**
+	 * the distinct periods in increasing order
+	 */
+	std::vector<int> periods;
+
+	/**
+	 * all the masks, one after the other
+	 */
+	std::vector<uint64_t> bits;
+
+	unsigned int side;
+
+	/**
+	 * number of 64 bit words of each row of a mask
+	 */
+	unsigned int words_per_row;
+};
+
+#endif /* CRITICALITYMASKS_H_ */
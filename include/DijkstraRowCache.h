@@ -0,0 +1,68 @@
+#ifndef DIJKSTRAROWCACHE_H_
+#define DIJKSTRAROWCACHE_H_
+
+#include <list>
+#include <vector>
+
+/**
+ * Small least recently used cache of the rows of W and D computed by the max
+ * delay Dijkstra from a single source.
+ * A row may come from a search that stopped early: in that case only its
+ * elements with distance not greater than the bound of the row are final.
+ */
+class DijkstraRowCache {
+public:
+	/**
+	 * construct an empty cache
+	 * @param capacity the maximum number of rows kept in the cache
+	 */
+	explicit DijkstraRowCache(unsigned int capacity);
+
+	/**
+	 * look for the final W and D values from source to target.
+	 * On success the row of source becomes the most recently used.
+	 * @param source the source node
+	 * @param target the target node
+	 * @param w set to W(source, target) if found
+	 * @param d set to D(source, target) if found
+	 * @return true if the values are in the cache, else false
+	 */
+	bool lookup(int source, int target, int &w, int &d);
+
+	/**
+	 * insert the row of source as the most recently used one, replacing the
+	 * old row of source or, if the cache is full, the least recently used
+	 * row. The given vectors are swapped with the buffers of the replaced
+	 * row (they become empty if no row is replaced), so a caller that keeps
+	 * them and reuses them for the next row allocates no memory once the
+	 * cache is full.
+	 * @param source the source node
+	 * @param bound the distance up to which the row is final
+	 * @param dist the distances from source (W row)
+	 * @param delay the delays from source (D row)
+	 */
+	void insert(int source, int bound, std::vector<int> &dist,
+			std::vector<int> &delay);
+
+	/**
+	 * remove all the rows, e.g. because the weights of the graph changed
+	 */
+	void clear();
+
+private:
+	struct Row {
+		int source;
+		int bound;
+		std::vector<int> dist;
+		std::vector<int> delay;
+	};
+
+	/**
+	 * the rows, from the most to the least recently used
+	 */
+	std::list<Row> rows;
+
+	unsigned int capacity;
+};
+
+#endif /* DIJKSTRAROWCACHE_H_ */
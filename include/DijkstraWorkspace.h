@@ -0,0 +1,99 @@
+#ifndef DIJKSTRAWORKSPACE_H_
+#define DIJKSTRAWORKSPACE_H_
+
+#include <utility>                          // for std::pair
+#include <vector>
+
+typedef std::pair<int, int> iPair;
+
+/**
+ * Scratch memory reused by consecutive runs of the max delay Dijkstra.
+ * The parent array and the priority queue are allocated once, then every
+ * run only pays for the vertices it actually touches: instead of clearing
+ * the parent array, each entry is stamped with the generation of the run
+ * that wrote it, so entries written by older runs read as "no parent".
+ */
+class DijkstraWorkspace {
+public:
+	/**
+	 * construct a workspace for graphs with the given number of vertices.
+	 * Parent and stamp arrays are carved out of a single arena allocation.
+	 * @param num_vertices the number of vertices of the graph
+	 */
+	explicit DijkstraWorkspace(unsigned int num_vertices);
+
+	/**
+	 * prepare the workspace for a new run.
+	 * It invalidates all the parents in O(1) and empties the queue keeping
+	 * its capacity.
+	 */
+	void reset();
+
+	/**
+	 * get the parent of v in the current run
+	 * @param v the vertex
+	 * @return the parent of v, or -1 if v has not a parent in the current run
+	 */
+	int get_parent(int v) const;
+
+	/**
+	 * set the parent of v in the current run
+	 * @param v the vertex
+	 * @param parent the parent of v (-1 for the root)
+	 */
+	void set_parent(int v, int parent);
+
+	/**
+	 * Tells if node v is in the path between src and end, where the
+	 * structure of the tree is described by the parents of the current run
+	 * @param v the node that you want to check if it is in the path
+	 * @param src the source node
+	 * @param end the end node
+	 * @return true if v is in the path, else false
+	 */
+	bool is_in_path(int v, int src, int end) const;
+
+	/**
+	 * insert a (distance, vertex) pair in the priority queue
+	 * @param p the pair to insert
+	 */
+	void push(const iPair &p);
+
+	/**
+	 * remove the pair with minimum distance from the priority queue
+	 * @return the removed pair
+	 */
+	iPair pop();
+
+	/**
+	 * get the pair with minimum distance without removing it
+	 * @return the pair with minimum distance
+	 */
+	const iPair &top() const;
+
+	/**
+	 * @return true if the priority queue is empty, else false
+	 */
+	bool empty() const;
+
+private:
+	/**
+	 * single allocation holding the parent array followed by the stamp array
+	 */
+	std::vector<int> arena;
+	int *parent;
+	int *stamp;
+
+	/**
+	 * generation of the current run. An entry of parent is valid only if
+	 * the corresponding stamp is equal to it.
+	 */
+	int generation;
+
+	/**
+	 * binary min heap used as priority queue
+	 */
+	std::vector<iPair> heap;
+};
+
+#endif /* DIJKSTRAWORKSPACE_H_ */
@@ -0,0 +1,232 @@
+#ifndef ENGINEHARNESS_H_
+#define ENGINEHARNESS_H_
+
+#include "RetimingManager.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * A graph given to the retiming, as it is passed to the in memory
+ * constructor of RetimingManager.
+ */
+struct HarnessCase {
+	std::vector<int> delays;
+	std::vector<Edge> edges;
+	std::vector<int> weights;
+	int control_steps;
+	int clock_period;
+};
+
+/**
+ * Function that builds a new RetimingManager on the graph under test, with
+ * the given required clock period.
+ */
+typedef std::function<RetimingManager(int clock_period)> ManagerFactory;
+
+/**
+ * Differential harness of the retiming engines.
+ * Every engine (region decomposition, parallel solver, point queries of W
+ * and D, criticality masks) is run on the same graph and compared with the
+ * reference pipeline, i.e. the whole graph solved on one thread by the boost
+ * bellman ford. The W, D and pC matrices, the legality of the retimed graph,
+ * its weights and its scheduling must be the same; the multi-threaded
+ * engines run with HARNESS_THREADS threads whatever the size of the graph.
+ * The criticality masks are checked on several periods at once against a
+ * reference run for each period. The scheduling of the reference is
+ * checked against a longest path over the retimed edges that go forward in
+ * program order, on the graphs whose other edges all close a loop and carry
+ * a flip flop, and against the known scheduling of some bundled graphs.
+ * A graph that the reference cannot retime is skipped if every engine fails
+ * with the same error. The runtime of each engine is summed over all the graphs, and
+ * failing random graphs are shrunk to a minimal graph written in the graph
+ * input file format.
+ */
+class EngineHarness {
+public:
+	/**
+	 * construct an harness without any graph run
+	 * @param reproducer_dir the directory where the shrunk failing graphs
+	 *                       are written, it must exist
+	 */
+	explicit EngineHarness(std::string reproducer_dir);
+
+	/**
+	 * compare the engines on a graph input file, for one and two control
+	 * steps and for every clock period from 1 to the one of the input graph,
+	 * and check the scheduling of the bundled graphs whose one is known
+	 * @param filename the path of the graph input file
+	 * @return true if all the engines agree with the reference
+	 */
+	bool run_input_file(std::string filename);
+
+	/**
+	 * compare the engines on random graphs made of loops, with a random
+	 * number of control steps and clock period. The vertices of a loop are
+	 * numbered in random order and the loop is entered at a random vertex;
+	 * some graphs are large enough to be split among threads by default.
+	 * @param count the number of graphs
+	 * @param seed the seed of the generator
+	 * @return true if all the engines agree with the reference on all the
+	 *         graphs
+	 */
+	bool run_random(unsigned int count, unsigned int seed);
+
+	/**
+	 * print in the standard output the number of graphs run, failed and
+	 * skipped, the number of schedulings checked and the total runtime of
+	 * each engine
+	 */
+	void print_report() const;
+
+	/**
+	 * get the number of graphs on which some engine failed
+	 * @return the number of failures
+	 */
+	unsigned int get_failures() const;
+
+private:
+	/**
+	 * what an engine produced on a graph, only the fields that the engine
+	 * computes are filled
+	 */
+	struct Outcome {
+		std::string error;
+		std::vector<int> w;
+		std::vector<int> d;
+		std::vector<int> pc;
+		std::vector<int> input_weights;
+		std::vector<int> weights;
+		std::vector<int> scheduling;
+		std::vector<int> parallelism_profile;
+		std::vector<Edge> edges;
+		int entry_delay;
+		bool feasible;
+		bool legal;
+	};
+
+	/**
+	 * run all the engines on a graph and compare them with the reference
+	 * @param make builds the graph
+	 * @param clock_period the required clock period of the graph
+	 * @param timed true if the runtime of the engines has to be recorded
+	 * @param skip set to true if the reference cannot retime the graph and
+	 *             the engines fail with the same error, so that the graph
+	 *             must not be counted
+	 * @return an empty string if the engines agree, else a description of
+	 *         the first difference found
+	 */
+	std::string compare(const ManagerFactory &make, int clock_period,
+			bool timed, bool &skip);
+
+	/**
+	 * check that the engines that retime a graph fail with the same error of
+	 * the reference. The point queries are not checked since they do not
+	 * retime the graph.
+	 * @param make builds the graph
+	 * @param clock_period the required clock period of the graph
+	 * @param reference the failed outcome of the reference
+	 * @return an empty string if they fail in the same way, else the
+	 *         difference
+	 */
+	std::string compare_errors(const ManagerFactory &make, int clock_period,
+			const Outcome &reference);
+
+	/**
+	 * run apply_retiming() with the given settings
+	 * @param make builds the graph
+	 * @param clock_period the required clock period of the graph
+	 * @param region_decomposition the region decomposition setting
+	 * @param parallel_pc_solver the parallel solver setting
+	 * @param num_threads the number of threads of the engine
+	 * @param engine the index of the engine whose runtime is recorded, or
+	 *               -1 if it is not recorded
+	 * @return the outcome of the retiming
+	 */
+	Outcome run_retiming(const ManagerFactory &make, int clock_period,
+			bool region_decomposition, bool parallel_pc_solver,
+			unsigned int num_threads, int engine);
+
+	/**
+	 * check the scheduling and the parallelism profile of a retimed graph
+	 * against an ASAP schedule computed here from program order: an edge
+	 * that enters the source or a vertex that is not after its tail ends an
+	 * iteration, and the step of any other vertex is the delay of the
+	 * source plus the longest path to it over the remaining edges.
+	 * The graph is checked only if each edge that ends an iteration, apart
+	 * from the ones that enter the source, has a flip flop in the input
+	 * graph and its head reaches its tail, and if each reachable vertex is
+	 * reached by a remaining edge.
+	 * @param outcome the outcome of the retiming
+	 * @return an empty string if they are the same or the graph is not
+	 *         checked, else the difference
+	 */
+	std::string check_scheduling(const Outcome &outcome);
+
+	/**
+	 * run evaluate_clock_periods() on several periods around the required
+	 * one and compare the feasibility and the critical pair counts of each
+	 * with the reference
+	 * @param make builds the graph
+	 * @param clock_period the required clock period of the graph
+	 * @param reference the outcome of the reference at clock_period
+	 * @param timed true if the runtime of the engine has to be recorded
+	 * @return an empty string if they agree, else the difference
+	 */
+	std::string compare_masks(const ManagerFactory &make, int clock_period,
+			const Outcome &reference, bool timed);
+
+	/**
+	 * compare the engines on a random graph, shrinking it if they disagree
+	 * @param c the graph
+	 * @return true if all the engines agree with the reference
+	 */
+	bool run_case(const HarnessCase &c);
+
+	/**
+	 * remove edges and vertices from a failing graph as long as it keeps
+	 * failing
+	 * @param c the failing graph
+	 * @return a graph that fails, but not if any edge or vertex is removed
+	 */
+	HarnessCase shrink(HarnessCase c);
+
+	/**
+	 * write a graph in the graph input file format, with the flip flops of
+	 * each edge in the third element of the line
+	 * @param c the graph
+	 * @param filename the name of the file
+	 */
+	void write_case(const HarnessCase &c, std::string filename) const;
+
+	/**
+	 * add the runtime of an engine
+	 * @param engine the index of the engine, or -1 to record nothing
+	 * @param start when the engine started
+	 */
+	void record_time(int engine,
+			std::chrono::steady_clock::time_point start);
+
+	std::string reproducer_dir;
+
+	/**
+	 * total seconds spent by each engine, indexed as ENGINE_NAMES
+	 */
+	std::vector<double> engine_seconds;
+
+	unsigned int cases;
+	unsigned int failures;
+
+	/**
+	 * graphs that no engine can retime
+	 */
+	unsigned int skipped;
+
+	/**
+	 * graphs whose scheduling has been checked by check_scheduling()
+	 */
+	unsigned int checked_schedulings;
+};
+
+#endif /* ENGINEHARNESS_H_ */
@@ -2,14 +2,20 @@
 #define RETIMINGMANAGER_H_
 
 #include "SquareMatrix.h"
+#include "DijkstraWorkspace.h"
+#include "DijkstraRowCache.h"
+#include "CriticalityMasks.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <utility>                          // for std::pair
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/adjacency_matrix.hpp>
 
 #define SOURCE 0 // source node
 
-typedef std::pair<int, int> iPair;
 // I have chosen adjacency_list over adjacency_matrix, because the number of edges approaches should be less than |V|^2.
 typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::bidirectionalS,
 		boost::no_property, boost::property<boost::edge_weight_t, int> > Graph;
@@ -22,11 +28,69 @@ typedef boost::property_map<Graph, boost::edge_weight_t>::type weights_map;
 typedef boost::property_map<Graph, boost::vertex_index_t>::type IndexMap;
 typedef boost::graph_traits<Graph> GraphTraits;
 
+/**
+ * Function called while apply_retiming() is running, with the name of the
+ * current phase and the number of steps done out of the total of the phase.
+ * It is never called by two threads at the same time.
+ */
+typedef std::function<void(const char *phase, unsigned int done,
+		unsigned int total)> ProgressCallback;
+
+/**
+ * Flag shared with apply_retiming(): setting it to true, from any thread,
+ * stops the retiming at the next progress step.
+ */
+typedef std::shared_ptr<std::atomic<bool> > CancellationToken;
+
+/**
+ * Statistics of the last run of apply_retiming(). If the run has been
+ * stopped they tell how far it went.
+ */
+struct RetimingStats {
+	RetimingStats() :
+			phase("not started"), done(0), total(0), elapsed_seconds(0), completed(
+					false), stopped(false) {
+	}
+
+	/**
+	 * the last phase reached
+	 */
+	const char *phase;
+
+	/**
+	 * the number of steps of the last phase that have been done
+	 */
+	unsigned int done;
+
+	/**
+	 * the total number of steps of the last phase (for the solver phase,
+	 * the maximum number of rounds)
+	 */
+	unsigned int total;
+
+	/**
+	 * seconds elapsed from the start of the run to the last progress step
+	 */
+	double elapsed_seconds;
+
+	/**
+	 * true if the run has not been stopped and it has moved the flip flops
+	 */
+	bool completed;
+
+	/**
+	 * true if the run has been cancelled or it has run out of time
+	 */
+	bool stopped;
+};
+
 class RetimingManager {
 public:
 	/**
 	 * Construct a RetimingManager object with the input graph contained in the
-	 * file named filename, with the given control steps and clock period
+	 * file named filename, with the given control steps and clock period.
+	 * It throws if the file cannot be opened, if it has no edge line or
+	 * for the same reasons of the constructor of a graph in memory.
 	 * @param filename the name of the file that contains the input graph
 	 * @param control_steps number of flip flops to be put in front of the source node
 	 * @param clock_period desired clock period for the application of the retiming algorithm
@@ -34,20 +98,125 @@ public:
 	RetimingManager(std::string filename, int control_steps, int clock_period);
 
 	/**
-	 * Copy constructor.
-	 * Construct a retiming manager with the same characteristics of another one
-	 * @param other the retiming manager that you want to copy
+	 * Construct a RetimingManager object with the input graph given in memory,
+	 * with the given control steps and clock period.
+	 * The arguments describe the graph in the same way as the input file.
+	 * It throws if delays is empty, if an edge has a vertex that is not in
+	 * [0, delays.size()) or if weights and edges have different sizes.
+	 * @param delays a vector that at position i contains the delay of node i
+	 * @param edges the edges of the graph, as (tail node, head node) pairs
+	 * @param weights a vector that at position i contains the number of flip
+	 *                flops of the i-th edge
+	 * @param control_steps number of flip flops to be put in front of the source node
+	 * @param clock_period desired clock period for the application of the retiming algorithm
+	 */
+	RetimingManager(const std::vector<int> &delays,
+			const std::vector<Edge> &edges, const std::vector<int> &weights,
+			int control_steps, int clock_period);
+
+	/**
+	 * Construct a RetimingManager object with the input graph given in memory,
+	 * without flip flops in the edges that do not start from the source.
+	 * @param delays a vector that at position i contains the delay of node i
+	 * @param edges the edges of the graph, as (tail node, head node) pairs
+	 * @param control_steps number of flip flops to be put in front of the source node
+	 * @param clock_period desired clock period for the application of the retiming algorithm
 	 */
-	RetimingManager(const RetimingManager& other);
+	RetimingManager(const std::vector<int> &delays,
+			const std::vector<Edge> &edges, int control_steps,
+			int clock_period);
 
 	/**
-	 * Overload of assignment operator. It copies the fields of the given retiming manager.
-	 * @param other the retiming manager that you want to copy the fields
+	 * Move constructor.
+	 * The other retiming manager is left empty and can only be destroyed or
+	 * assigned.
+	 * @param other the retiming manager that you want to move
+	 */
+	RetimingManager(RetimingManager&& other);
+
+	/**
+	 * Move assignment operator.
+	 * @param other the retiming manager that you want to move
 	 * @return the starting retiming manager, but with the fields of the other one.
 	 */
-	RetimingManager& operator=(RetimingManager other);
+	RetimingManager& operator=(RetimingManager&& other);
+
+	RetimingManager(const RetimingManager& other) = delete;
+	RetimingManager& operator=(const RetimingManager& other) = delete;
 	virtual ~RetimingManager();
 
+	/**
+	 * Restore the input graph and set a new clock period and number of
+	 * control steps, so that apply_retiming() can be called again.
+	 * No memory is allocated: matrices, pc graph and cached orders are reused.
+	 * @param clock_period desired clock period for the application of the retiming algorithm
+	 * @param control_steps number of flip flops to be put in front of the source node
+	 */
+	void reset(int clock_period, int control_steps);
+
+	/**
+	 * Enable or disable the region decomposition (enabled by default).
+	 * If the source has no incoming edges, the graph without the source is
+	 * split in weakly connected regions; each region, together with the
+	 * source, is retimed as an independent problem and the regions are
+	 * solved in parallel. W, D and pC are then only stored for the pairs of
+	 * vertices of the same region, but the result is the same as the one
+	 * of the whole graph.
+	 * @param enabled true to retime the regions separately, false to always
+	 *                retime the whole graph
+	 */
+	void set_region_decomposition(bool enabled);
+
+	/**
+	 * Choose how the pC constraints are solved (parallel by default).
+	 * The parallel solver relaxes the rows of the pC matrix on more threads,
+	 * without building the pC graph; the serial one applies
+	 * boost::bellman_ford_shortest_paths on the pC graph. Both find the same
+	 * distances and the same negative cycles.
+	 * @param enabled true for the parallel solver, false for the boost one
+	 */
+	void set_parallel_pc_solver(bool enabled);
+
+	/**
+	 * Set the number of threads used to build the rows of the matrices, to
+	 * solve the pC constraints and to retime the regions.
+	 * @param num_threads the number of threads, or 0 (the default) to use
+	 *                    one thread for graphs smaller than 256 vertices
+	 *                    and all the hardware threads for the others
+	 */
+	void set_num_threads(unsigned int num_threads);
+
+	/**
+	 * Set the function that is called at each progress step of
+	 * apply_retiming(): every row of W, D and pC (phase "W, D and pC
+	 * matrices"), every round of the pC solver and, if the graph is
+	 * decomposed, every region solved.
+	 * @param callback the function to call, or nullptr for none
+	 */
+	void set_progress_callback(ProgressCallback callback);
+
+	/**
+	 * Set the token that stops apply_retiming(). When it is set, the next
+	 * progress step throws and the main graph is left unchanged.
+	 * @param token the token, or nullptr for none
+	 */
+	void set_cancellation_token(CancellationToken token);
+
+	/**
+	 * Set the maximum wall-clock time of apply_retiming(). When it is
+	 * exceeded, the next progress step throws and the main graph is left
+	 * unchanged.
+	 * @param budget the maximum time, or 0 for no limit
+	 */
+	void set_time_budget(std::chrono::milliseconds budget);
+
+	/**
+	 * Get the statistics of the last apply_retiming(), also if it has been
+	 * stopped.
+	 * @return the statistics of the last run
+	 */
+	RetimingStats get_stats() const;
+
 	/**
 	 * Get W matrix
 	 * @return W matrix
@@ -66,6 +235,19 @@ public:
 	 */
 	SquareMatrix get_pc_matrix() const;
 
+	/**
+	 * Get W(u,v) and D(u,v) of the current main graph without building the
+	 * matrices: a single max delay Dijkstra is run from u and stopped as soon
+	 * as v is settled. The rows computed in this way are kept in a small
+	 * least recently used cache, so repeated queries from the same node are
+	 * answered without searching again, until the weights change.
+	 * @param u the tail node
+	 * @param v the head node
+	 * @return the pair (W(u,v), D(u,v)); W(u,v) is INF if v cannot be
+	 *         reached from u
+	 */
+	iPair query_w_d(int u, int v);
+
 	/**
 	 * print in the standard output the main graph
 	 */
@@ -80,20 +262,122 @@ public:
 	 */
 	void write_main_graph(std::string filename) const;
 
+	/**
+	 * get the flip flops of the edges of the main graph
+	 * @return a vector with the weight of each edge, in the order in which
+	 *         write_main_graph() writes the edges
+	 */
+	std::vector<int> get_weights() const;
+
+	/**
+	 * get the edges of the main graph
+	 * @return a vector with the (tail node, head node) pair of each edge, in
+	 *         the same order of get_weights()
+	 */
+	std::vector<Edge> get_edges() const;
+
+	/**
+	 * get the delays of the nodes
+	 * @return a vector that at index i contains the delay of node i
+	 */
+	const std::vector<int> &get_delays() const;
+
 	/**
 	 * Calculate the scheduling.
 	 * Call this function after you have called the apply_retiming() function.
+	 * The schedule of each instruction is the maximum among all its incoming
+	 * edges (loop back edges excluded) of the schedule of the predecessor
+	 * plus the flip flops of the edge. It is computed with a single pass over
+	 * the topological order cached at construction time, so it can be
+	 * called again after any change of the weights.
 	 * @return a vector that at index i contains the schedule of the i-th instruction
 	 */
 	std::vector<int> get_scheduling() const;
 
+	/**
+	 * Calculate the scheduling and its parallelism profile.
+	 * @see get_scheduling()
+	 * @param parallelism_profile vector filled so that at index s it contains
+	 *                            the number of instructions scheduled in step s
+	 * @return a vector that at index i contains the schedule of the i-th instruction
+	 */
+	std::vector<int> get_scheduling(std::vector<int> &parallelism_profile) const;
+
 	/**
 	 * apply the full retiming algorithm: calculate w, d and pc matrix;
 	 * calculate and analyze pc graph and finally (if it doesn't contain
 	 * negative cycles) move flip flops in the main graph.
+	 * The clock period of the input graph is measured before, and if the flip
+	 * flops have been moved the clock period achieved by the resulting graph
+	 * is measured and compared with the required one.
 	 */
 	void apply_retiming();
 
+	/**
+	 * Tell, for each of the given clock periods, if the main graph can be
+	 * retimed to meet it, without moving any flip flop. W and D matrices are
+	 * built only once and the critical pairs of all the periods are stored
+	 * in one bitset per period, from which the pC matrix of each period is
+	 * derived in turn. When it returns, the pC matrix is the one of the
+	 * largest period.
+	 * @param periods the candidate clock periods
+	 * @return a vector that at index i is true if periods[i] is feasible
+	 */
+	std::vector<bool> evaluate_clock_periods(const std::vector<int> &periods);
+
+	/**
+	 * Tell, for each of the given clock periods, if the main graph can be
+	 * retimed to meet it, and count its critical pairs with the bitsets.
+	 * @see evaluate_clock_periods(const std::vector<int>&)
+	 * @param periods the candidate clock periods
+	 * @param critical_pairs vector filled so that at index i it contains the
+	 *                       number of pairs (u,v) with D(u,v) > periods[i]
+	 * @param relaxed_pairs vector filled so that at index i it contains the
+	 *                      number of pairs that are critical for the largest
+	 *                      given period lower than periods[i] but not for
+	 *                      periods[i], 0 if there is none
+	 * @return a vector that at index i is true if periods[i] is feasible
+	 */
+	std::vector<bool> evaluate_clock_periods(const std::vector<int> &periods,
+			std::vector<unsigned long> &critical_pairs,
+			std::vector<unsigned long> &relaxed_pairs);
+
+	/**
+	 * Calculate the clock period of the main graph, i.e. the largest delay of
+	 * a path without flip flops, with a single pass in topological order over
+	 * the edges with weight 0. It takes O(V+E).
+	 * It can be called both before and after apply_retiming().
+	 * @param critical_path vector filled with the vertices of a path that
+	 *                      has the returned delay, from its first to its last
+	 *                      vertex
+	 * @return the clock period of the main graph
+	 */
+	int compute_clock_period(std::vector<int> &critical_path) const;
+
+	/**
+	 * Calculate the clock period of the main graph.
+	 * @see compute_clock_period(std::vector<int>&)
+	 * @return the clock period of the main graph
+	 */
+	int compute_clock_period() const;
+
+	/**
+	 * Get the clock period measured on the main graph at the beginning of
+	 * apply_retiming(), once it is known that the graph has no cycles
+	 * without flip flops.
+	 * @return the input clock period, or -1 if apply_retiming() has not
+	 *         been called or the graph has cycles
+	 */
+	int get_input_clock_period() const;
+
+	/**
+	 * Get the clock period measured on the main graph at the end of
+	 * apply_retiming().
+	 * @return the achieved clock period, or -1 if apply_retiming() has not
+	 *         been called or it has not moved the flip flops
+	 */
+	int get_achieved_clock_period() const;
+
 private:
 	/**
 	 * the graph that will be taken as input and modified to be written in
@@ -102,7 +386,7 @@ private:
 	 * because the number of edges approaches should be less than |V|^2 in
 	 * general.
 	 */
-	Graph *main_graph;
+	std::unique_ptr<Graph> main_graph;
 
 	/**
 	 * A vector that at position i contains the delay of instruction i.
@@ -110,23 +394,29 @@ private:
 	 */
 	std::vector<int> delays;
 
+	/**
+	 * the weights of the edges of the input graph, in the order in which
+	 * boost::edges() visits them, used to restore the graph in reset()
+	 */
+	std::vector<int> input_weights;
+
 	/**
 	 * w matrix is the cost of the minimum path from row element to column one
 	 */
-	SquareMatrix *w;
+	std::unique_ptr<SquareMatrix> w;
 
 	/**
 	 * The D matrix contains elements Dij, where Dij is the largest delay of a
 	 * path from node i to node j which has the minimum number of latches.
 	 * If i = j than Dii corresponds to delay of node i.
 	 */
-	SquareMatrix *d;
+	std::unique_ptr<SquareMatrix> d;
 
 	/**
 	 * This matrix represents a graph where PC(i,j) is the weight of the edge
 	 * which goes from node j to node i.
 	 */
-	SquareMatrix *pc;
+	std::unique_ptr<SquareMatrix> pc;
 
 	/**
 	 * the graph created starting from pC matrix.
@@ -135,7 +425,136 @@ private:
 	 * For this graph, I have chosen adjacency_matrix over adjacency_list,
 	 * because the number of edges approaches should be greater than |V|^2
 	 */
-	DenseGraph *pc_graph;
+	std::unique_ptr<DenseGraph> pc_graph;
+
+	/**
+	 * the vertices reachable from the source in topological order of the
+	 * main graph without its loop back edges.
+	 * It depends only on the structure of the graph, so it is built once.
+	 */
+	std::vector<int> topological_order;
+
+	/**
+	 * A vector that at position i contains the strongly connected component
+	 * of vertex i in the main graph without the edges entering the source,
+	 * i.e. the loop that contains it.
+	 */
+	std::vector<int> loop_component;
+
+	/**
+	 * A vector that at position c is true if every reachable vertex of loop
+	 * c is reached by an edge that goes forward in program order, so that
+	 * its back edges are the ones that go to a previous operation. It is
+	 * false for instance if the loop is entered above its lowest vertex.
+	 */
+	std::vector<bool> program_ordered;
+
+	/**
+	 * A vector that at position i contains the time at which vertex i is
+	 * discovered by the depth first search from the source, -1 if it is not
+	 * reachable. It is used only by the loops that are not program ordered.
+	 */
+	std::vector<int> discover_time;
+
+	/**
+	 * A vector that at position i contains the time at which the depth first
+	 * search from the source finishes vertex i, -1 if it is not reachable.
+	 */
+	std::vector<int> finish_time;
+
+	/**
+	 * true if apply_retiming() is allowed to split the graph in regions
+	 */
+	bool region_decomposition;
+
+	/**
+	 * true if the pC constraints are solved by solve_pc_matrix(), false if
+	 * they are solved by solve_pc_graph()
+	 */
+	bool parallel_pc_solver;
+
+	/**
+	 * the number of threads set by set_num_threads(), 0 to choose them from
+	 * the size of the graph
+	 */
+	unsigned int num_threads;
+
+	/**
+	 * function called at each progress step
+	 */
+	ProgressCallback progress_callback;
+
+	/**
+	 * flag that stops the retiming when it is set
+	 */
+	CancellationToken cancellation_token;
+
+	/**
+	 * maximum duration of apply_retiming(), 0 for no limit
+	 */
+	std::chrono::milliseconds time_budget;
+
+	/**
+	 * the instant at which the last apply_retiming() started
+	 */
+	std::chrono::steady_clock::time_point start_time;
+
+	/**
+	 * the instant at which the last apply_retiming() has to stop, if
+	 * time_budget is not 0
+	 */
+	std::chrono::steady_clock::time_point deadline;
+
+	/**
+	 * statistics of the last apply_retiming()
+	 */
+	RetimingStats stats;
+
+	/**
+	 * true if the last apply_retiming() has solved the regions separately.
+	 * In this case w, d, pc and pc_graph are not used and the matrices are
+	 * stored in the regions.
+	 */
+	bool decomposed;
+
+	/**
+	 * A vector that at position k contains the vertices of region k, in
+	 * increasing order and preceded by the source. The position of a vertex
+	 * in this vector is its index in the graph of the region.
+	 * It is empty if the graph cannot be decomposed.
+	 */
+	std::vector<std::vector<int> > region_vertices;
+
+	/**
+	 * A vector that at position i contains the region of vertex i, or -1 for
+	 * the source
+	 */
+	std::vector<int> vertex_region;
+
+	/**
+	 * the retiming managers of the regions, created the first time that the
+	 * graph is retimed by region and reused by the next runs
+	 */
+	std::vector<std::unique_ptr<RetimingManager> > regions;
+
+	/**
+	 * the rows of W and D computed by query_w_d()
+	 */
+	DijkstraRowCache row_cache;
+
+	/**
+	 * scratch memory of the searches of query_w_d(), allocated by the first
+	 * one
+	 */
+	std::unique_ptr<DijkstraWorkspace> query_workspace;
+
+	/**
+	 * scratch W and D rows of query_w_d(). Inserting them in row_cache
+	 * swaps them with the buffers of the replaced row, which are reused by
+	 * the next search.
+	 */
+	std::vector<int> query_dist;
+	std::vector<int> query_delays;
 
 	/**
 	 * the required clock period
@@ -143,20 +562,164 @@ private:
 	int clock_period;
 
 	/**
-	 * build W and D matrices
+	 * the clock period of the main graph measured before the retiming
+	 */
+	int input_clock_period;
+
+	/**
+	 * the clock period of the main graph measured after the retiming
+	 */
+	int achieved_clock_period;
+
+	/**
+	 * Construct an empty RetimingManager, used for the regions
 	 */
-	void build_w_d_matrices();
+	RetimingManager();
 
 	/**
-	 * build pC matrix
+	 * build the main graph from the given edges, save its input weights and
+	 * find its topological order and its regions.
+	 * The matrices are allocated when they are built for the first time.
+	 * delays must be already set, it throws if it is empty or if an edge
+	 * has a vertex out of it.
+	 * @param edges the edges of the graph
+	 * @param weights the weights of the edges
 	 */
-	void build_pc_matrix();
+	void build_main_graph(const std::vector<Edge> &edges,
+			const std::vector<int> &weights);
 
 	/**
-	 * build pC graph starting from pC matrix
+	 * set the input weight of the outgoing arcs of the source
+	 * @param control_steps the weight of the outgoing arcs of the source
+	 */
+	void set_control_steps(int control_steps);
+
+	/**
+	 * set the weights of the main graph back to input_weights
+	 */
+	void restore_input_weights();
+
+	/**
+	 * build region_vertices and vertex_region
+	 */
+	void build_regions();
+
+	/**
+	 * create the retiming managers of the regions, if they do not exist, and
+	 * copy into them the current weights of the main graph and the clock
+	 * period
+	 */
+	void load_regions();
+
+	/**
+	 * solve W, D, pC and pC graph of every region in parallel, then join
+	 * their retimings and move the flip flops of the main graph
+	 * @return false if the pC graph of a region contains negative cycles,
+	 *         i.e. the flip flops have not been moved, else true
+	 */
+	bool apply_retiming_by_region();
+
+	/**
+	 * get a copy of a matrix, joining the matrices of the regions if the
+	 * last retiming has been decomposed
+	 * @param matrix the matrix that you want to get
+	 * @param default_value the value of the elements that are not computed
+	 * @return the matrix with the side of the main graph
+	 */
+	SquareMatrix assemble_matrix(
+			std::unique_ptr<SquareMatrix> RetimingManager::*matrix,
+			int default_value) const;
+
+	/**
+	 * build loop_component, program_ordered, discover_time, finish_time and
+	 * topological_order
+	 */
+	void build_topological_order();
+
+	/**
+	 * Tells if the edge (u,v) is a loop back edge, i.e. it enters the source
+	 * or, since operations are numbered in program order, it goes back to
+	 * a previous operation of the same loop. In a loop that is not program
+	 * ordered, it is an edge that the depth first search from the source
+	 * finds while v is still on the stack.
+	 * Both u and v must be reachable from the source.
+	 * @param u the tail node
+	 * @param v the head node
+	 * @return true if (u,v) is a back edge, else false
+	 */
+	bool is_back_edge(int u, int v) const;
+
+	/**
+	 * get the number of threads among which a matrix is split
+	 * @param rows the number of rows of the matrix
+	 * @return the number of threads set by set_num_threads() if any, else
+	 *         1 for small matrices and the number of hardware threads for
+	 *         the others
+	 */
+	unsigned int count_threads(unsigned int rows) const;
+
+	/**
+	 * build W and D matrices, and optionally pC matrix, as a pipeline: the
+	 * sources are taken by the workers one at a time and, as soon as the
+	 * row of W and D of a source is final, the same worker emits its row of
+	 * pC (and of the pC graph, if it is used by the solver), so no phase
+	 * waits for the whole previous matrix
+	 * @param with_pc true if pC matrix has to be built too
+	 * @param num_threads the number of workers
+	 */
+	void build_matrices(bool with_pc, unsigned int num_threads);
+
+	/**
+	 * allocate pC matrix and, if the solver uses it, pC graph
+	 */
+	void allocate_pc();
+
+	/**
+	 * build a row of pC matrix from the same row of W and D matrices
+	 * @param i the index of the row
+	 */
+	void build_pc_row(unsigned int i);
+
+	/**
+	 * build pC matrix for one of the periods of the masks
+	 * @param masks the critical pairs of the candidate periods
+	 * @param k the index of the period in masks
+	 */
+	void build_pc_matrix(const CriticalityMasks &masks, unsigned int k);
+
+	/**
+	 * solve the pC constraints of every period, the main graph is not
+	 * split in regions
+	 * @see evaluate_clock_periods()
+	 * @param periods the candidate clock periods
+	 * @param critical_pairs the critical pairs of each period are added to it
+	 * @param relaxed_pairs the relaxed pairs of each period are added to it
+	 * @return a vector that at index i is true if periods[i] is feasible
+	 */
+	std::vector<bool> evaluate_masks(const std::vector<int> &periods,
+			std::vector<unsigned long> &critical_pairs,
+			std::vector<unsigned long> &relaxed_pairs);
+
+	/**
+	 * Check that the main graph has no cycles without flip flops, reset the
+	 * statistics and the deadline, decide if the run is decomposed, then
+	 * call run and record its elapsed time, also if it throws.
+	 * @param run the body of the run, it returns true if it completed
+	 */
+	void run_measured(const std::function<bool()> &run);
+
+	/**
+	 * build pC graph with all its edges, if it does not exist yet.
+	 * The weights of the edges are written by update_pc_graph_row().
 	 */
 	void build_pc_graph();
 
+	/**
+	 * copy a row of pC matrix in the weights of the edges of pC graph
+	 * @param i the index of the row
+	 */
+	void update_pc_graph_row(unsigned int i);
+
 	/**
 	 * Basic Dijkstra algorithm, but with the if statement modified in order to
 	 * maximize the delay among all the possible shortest paths.
@@ -166,14 +729,61 @@ private:
 	 * @param src the dource node
 	 * @param dist distance array
 	 * @param tot_delays total delays of nodes array
+	 * @param workspace scratch memory for the parents and the priority queue,
+	 *                  reused across the runs of different sources
+	 * @param target if it is not -1, the search stops as soon as the
+	 *               distance and the delay of target are final
+	 * @return the distance up to which dist and tot_delays are final, i.e.
+	 *         the distance of target if the search stopped early, else INF
+	 */
+	int dijkstra_max_delay(int src, int* dist, int* tot_delay,
+			DijkstraWorkspace &workspace, int target = -1);
+
+	/**
+	 * Record a progress step, call the progress callback and stop the
+	 * retiming if it has been cancelled or it is out of time.
+	 * @param phase the name of the current phase
+	 * @param done the number of steps of the phase done
+	 * @param total the total number of steps of the phase
+	 */
+	void report_progress(const char *phase, unsigned int done,
+			unsigned int total);
+
+	/**
+	 * Apply bellman ford shortest paths algorithm on the pC graph.
+	 * @param pc_distances vector filled with the minimum distances from the
+	 *                     origin of the pC graph
+	 * @return false if the pC graph contains negative cycles, else true
+	 */
+	bool solve_pc_graph(std::vector<int> &pc_distances);
+
+	/**
+	 * Apply a parallel bellman ford directly on the pC matrix: in each round
+	 * the rows are split among the same threads and relaxed against the
+	 * distances of the previous round, with a barrier between the rounds.
+	 * @param pc_distances vector filled with the minimum distances from the
+	 *                     origin of the pC graph
+	 * @param num_threads the number of threads
+	 * @return false if the pC graph contains negative cycles, else true
+	 */
+	bool solve_pc_matrix(std::vector<int> &pc_distances,
+			unsigned int num_threads);
+
+	/**
+	 * Solve the pC constraints with the chosen solver
+	 * @param pc_distances vector filled with the minimum distances from the
+	 *                     origin of the pC graph
+	 * @param num_threads the number of threads of the parallel solver
+	 * @return false if the pC graph contains negative cycles, else true
 	 */
-	void dijkstra_max_delay(int src, int* dist, int* tot_delay);
+	bool solve_pc(std::vector<int> &pc_distances, unsigned int num_threads);
 
 	/**
 	 * Apply bellman ford shortest paths algorithm on the pC graph.
 	 * If the algorithm doesn't find negative cycles, then move the flip flops
+	 * @return true if the flip flops have been moved, else false
 	 */
-	void apply_final_step();
+	bool apply_final_step();
 
 	/**
 	 * move the flip flop according to retiming algorithm. This function
@@ -185,8 +795,7 @@ private:
 
 	/**
 	 * swap the field of two Retiming Managers.
-	 * It is used for the copy constructor and the overload of the
-	 * assignment operator.
+	 * It is used for the move assignment operator.
 	 * @param first the first Retiming Manager that you want to swap the fields
 	 * @param second the second Retiming Manager that you want to swap the fields
 	 */
@@ -196,6 +805,7 @@ private:
 	 * read the edges from the given Input file stream and save them and their
 	 * weights in the given vectors.
 	 * Optionally, you can specify the weight after the tail and the head node.
+	 * It throws if the first edge line has less than two values.
 	 * @param infile the Input file stream where the edges start
 	 * @param weights the vector of the weights
 	 * @param edges the vector of the edges
@@ -205,7 +815,8 @@ private:
 	void read_edges(std::ifstream &infile, std::vector<int> &weights,
 			std::vector<Edge> &edges, int control_steps);
 
-	bool is_main_graph_cyclic_util(int v, bool visited[], bool *recStack);
+	bool is_main_graph_cyclic_util(int v, std::vector<bool> &visited,
+			std::vector<bool> &recStack);
 	bool is_main_graph_cyclic();
 };
 
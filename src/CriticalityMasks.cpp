@@ -0,0 +1,80 @@
+#include "CriticalityMasks.h"
+
+#include <algorithm>
+
+CriticalityMasks::CriticalityMasks(const SquareMatrix &d,
+		const std::vector<int> &periods) :
+		periods(periods) {
+	std::sort(this->periods.begin(), this->periods.end());
+	this->periods.erase(std::unique(this->periods.begin(), this->periods.end()),
+			this->periods.end());
+	side = d.get_side();
+	words_per_row = (side + 63) / 64;
+	bits.assign(
+			(unsigned long) this->periods.size() * side * words_per_row, 0);
+
+	const unsigned long mask_size = (unsigned long) side * words_per_row;
+	for (unsigned int i = 0; i < side; i++) {
+		for (unsigned int j = 0; j < side; j++) {
+			/*
+			 * the pair is critical for all the periods lower than D(i,j),
+			 * that are the first level ones since periods are sorted
+			 */
+			const unsigned int level = std::lower_bound(
+					this->periods.begin(), this->periods.end(), d.get(i, j))
+					- this->periods.begin();
+			const uint64_t bit = (uint64_t) 1 << (j % 64);
+			uint64_t *word = &bits[(unsigned long) i * words_per_row + j / 64];
+			for (unsigned int k = 0; k < level; k++) {
+				word[k * mask_size] |= bit;
+			}
+		}
+	}
+}
+
+unsigned int CriticalityMasks::get_num_periods() const {
+	return periods.size();
+}
+
+unsigned int CriticalityMasks::get_index(int period) const {
+	return std::lower_bound(periods.begin(), periods.end(), period)
+			- periods.begin();
+}
+
+const uint64_t *CriticalityMasks::row(unsigned int k, unsigned int i) const {
+	return &bits[((unsigned long) k * side + i) * words_per_row];
+}
+
+void CriticalityMasks::build_pc_row(unsigned int k, unsigned int i,
+		const int *w_row, int *pc_row) const {
+	std::copy(w_row, w_row + side, pc_row);
+	const uint64_t *words = row(k, i);
+	for (unsigned int t = 0; t < words_per_row; t++) {
+		// clear the lowest set bit at each step
+		for (uint64_t word = words[t]; word != 0; word &= word - 1) {
+			pc_row[t * 64 + __builtin_ctzll(word)]--;
+		}
+	}
+}
+
+unsigned long CriticalityMasks::count_critical(unsigned int k) const {
+	const uint64_t *words = row(k, 0);
+	const unsigned long mask_size = (unsigned long) side * words_per_row;
+	unsigned long count = 0;
+	for (unsigned long t = 0; t < mask_size; t++) {
+		count += __builtin_popcountll(words[t]);
+	}
+	return count;
+}
+
+unsigned long CriticalityMasks::count_difference(unsigned int k,
+		unsigned int l) const {
+	const uint64_t *first = row(k, 0);
+	const uint64_t *second = row(l, 0);
+	const unsigned long mask_size = (unsigned long) side * words_per_row;
+	unsigned long count = 0;
+	for (unsigned long t = 0; t < mask_size; t++) {
+		count += __builtin_popcountll(first[t] & ~second[t]);
+	}
+	return count;
+}
@@ -0,0 +1,51 @@
+#include "DijkstraRowCache.h"
+
+DijkstraRowCache::DijkstraRowCache(unsigned int capacity) {
+	this->capacity = capacity;
+}
+
+bool DijkstraRowCache::lookup(int source, int target, int &w, int &d) {
+	for (std::list<Row>::iterator it = rows.begin(); it != rows.end(); ++it) {
+		if (it->source != source) {
+			continue;
+		}
+		if (it->dist[target] > it->bound) {
+			// the search that computed the row did not reach target
+			return false;
+		}
+		rows.splice(rows.begin(), rows, it);
+		w = it->dist[target];
+		d = it->delay[target];
+		return true;
+	}
+	return false;
+}
+
+void DijkstraRowCache::insert(int source, int bound, std::vector<int> &dist,
+		std::vector<int> &delay) {
+	if (capacity == 0) {
+		return;
+	}
+	std::list<Row>::iterator it = rows.begin();
+	while (it != rows.end() && it->source != source) {
+		++it;
+	}
+	if (it == rows.end()) {
+		if (rows.size() < capacity) {
+			rows.push_front(Row());
+		} else {
+			rows.splice(rows.begin(), rows, --rows.end());
+		}
+	} else {
+		rows.splice(rows.begin(), rows, it);
+	}
+	Row &row = rows.front();
+	row.source = source;
+	row.bound = bound;
+	row.dist.swap(dist);
+	row.delay.swap(delay);
+}
+
+void DijkstraRowCache::clear() {
+	rows.clear();
+}
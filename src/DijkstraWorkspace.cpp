@@ -0,0 +1,66 @@
+#include "DijkstraWorkspace.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+DijkstraWorkspace::DijkstraWorkspace(unsigned int num_vertices) :
+		arena(2 * num_vertices, 0) {
+	parent = arena.data();
+	stamp = arena.data() + num_vertices;
+	generation = 0;
+	heap.reserve(num_vertices);
+}
+
+void DijkstraWorkspace::reset() {
+	if (generation == std::numeric_limits<int>::max()) {
+		// stamps would wrap around, so clear them for real
+		std::fill(arena.begin(), arena.end(), 0);
+		generation = 0;
+	}
+	generation++;
+	heap.clear();
+}
+
+int DijkstraWorkspace::get_parent(int v) const {
+	return stamp[v] == generation ? parent[v] : -1;
+}
+
+void DijkstraWorkspace::set_parent(int v, int parent) {
+	this->parent[v] = parent;
+	stamp[v] = generation;
+}
+
+bool DijkstraWorkspace::is_in_path(int v, int src, int end) const {
+	int i = end;
+	if (v == src || v == end) {
+		return true;
+	}
+	while (get_parent(i) != -1) {
+		if (v == get_parent(i)) {
+			return true;
+		}
+		i = get_parent(i);
+	}
+	return false;
+}
+
+void DijkstraWorkspace::push(const iPair &p) {
+	heap.push_back(p);
+	std::push_heap(heap.begin(), heap.end(), std::greater<iPair>());
+}
+
+iPair DijkstraWorkspace::pop() {
+	std::pop_heap(heap.begin(), heap.end(), std::greater<iPair>());
+	const iPair top = heap.back();
+	heap.pop_back();
+	return top;
+}
+
+const iPair &DijkstraWorkspace::top() const {
+	return heap.front();
+}
+
+bool DijkstraWorkspace::empty() const {
+	return heap.empty();
+}
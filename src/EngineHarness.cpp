@@ -0,0 +1,620 @@
+#include "EngineHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+
+// threads of the multi-threaded engines, even on small graphs
+#define HARNESS_THREADS 4
+// one random graph out of LARGE_GRAPH_RATE has a loop split among threads
+#define LARGE_GRAPH_RATE 50
+
+/**
+ * the engines, in the order of ENGINE_NAMES, the first one is the reference
+ */
+enum Engine {
+	REFERENCE,
+	REGIONS,
+	PARALLEL_SOLVER,
+	REGIONS_PARALLEL_SOLVER,
+	POINT_QUERIES,
+	CRITICALITY_MASKS,
+	NUM_ENGINES
+};
+
+// passed instead of an engine when the runtime is not recorded
+#define UNTIMED -1
+
+static const char *ENGINE_NAMES[NUM_ENGINES] = { "reference", "regions",
+		"parallel solver", "regions + parallel solver", "point queries",
+		"criticality masks" };
+
+/**
+ * scheduling of a bundled input graph with one control step, before the
+ * retiming
+ */
+struct KnownScheduling {
+	const char *filename;
+	std::vector<int> scheduling;
+};
+
+/**
+ * the bundled graphs whose scheduling is known: in while8 the edges from 16
+ * go back to previous operations of the loop, and loop_entry is a loop
+ * entered at its highest vertex
+ */
+static const KnownScheduling KNOWN_SCHEDULINGS[] = {
+		{ "example1.txt", { 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 } },
+		{ "while8.txt", { 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2,
+				2 } },
+		{ "loop_entry.txt", { 0, 1, 1, 1 } } };
+
+/**
+ * copy a matrix in a vector, row by row
+ */
+static std::vector<int> flatten(const SquareMatrix &matrix) {
+	std::vector<int> values;
+	for (unsigned int i = 0; i < matrix.get_side(); i++) {
+		values.insert(values.end(), matrix.get()[i],
+				matrix.get()[i] + matrix.get_side());
+	}
+	return values;
+}
+
+/**
+ * tell if a vertex reaches another one without entering the source
+ * @param from the first vertex
+ * @param to the second vertex
+ * @param out the indices of the edges that leave each vertex
+ * @param edges the edges
+ * @return true if there is a path from from to to
+ */
+static bool reaches(int from, int to,
+		const std::vector<std::vector<int> > &out,
+		const std::vector<Edge> &edges) {
+	std::vector<bool> visited(out.size(), false);
+	std::vector<int> queue(1, from);
+	visited[from] = true;
+	for (unsigned int k = 0; k < queue.size(); k++) {
+		if (queue[k] == to) {
+			return true;
+		}
+		for (auto e : out[queue[k]]) {
+			const int v = edges[e].second;
+			if (v != SOURCE && !visited[v]) {
+				visited[v] = true;
+				queue.push_back(v);
+			}
+		}
+	}
+	return false;
+}
+
+EngineHarness::EngineHarness(std::string reproducer_dir) :
+		reproducer_dir(reproducer_dir), engine_seconds(NUM_ENGINES, 0) {
+	cases = 0;
+	failures = 0;
+	skipped = 0;
+	checked_schedulings = 0;
+}
+
+void EngineHarness::record_time(int engine,
+		std::chrono::steady_clock::time_point start) {
+	if (engine != UNTIMED) {
+		engine_seconds[engine] += std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+EngineHarness::Outcome EngineHarness::run_retiming(const ManagerFactory &make,
+		int clock_period, bool region_decomposition, bool parallel_pc_solver,
+		unsigned int num_threads, int engine) {
+	Outcome outcome;
+	outcome.entry_delay = 0;
+	outcome.feasible = false;
+	outcome.legal = false;
+	const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	// the graph itself may be rejected, like by the file constructor
+	std::unique_ptr<RetimingManager> manager;
+	try {
+		manager.reset(new RetimingManager(make(clock_period)));
+		manager->set_region_decomposition(region_decomposition);
+		manager->set_parallel_pc_solver(parallel_pc_solver);
+		manager->set_num_threads(num_threads);
+		outcome.input_weights = manager->get_weights();
+		manager->apply_retiming();
+	} catch (const char *msg) {
+		record_time(engine, start);
+		outcome.error = msg;
+		return outcome;
+	}
+	record_time(engine, start);
+	const RetimingManager &rm = *manager;
+	outcome.w = flatten(rm.get_w_matrix());
+	outcome.d = flatten(rm.get_d_matrix());
+	outcome.pc = flatten(rm.get_pc_matrix());
+	outcome.weights = rm.get_weights();
+	outcome.edges = rm.get_edges();
+	outcome.entry_delay = rm.get_delays()[SOURCE];
+	outcome.scheduling = rm.get_scheduling(outcome.parallelism_profile);
+	// the flip flops are moved only if the clock period can be met
+	outcome.feasible = rm.get_stats().completed;
+	outcome.legal = std::find_if(outcome.weights.begin(),
+			outcome.weights.end(), [](int weight) {return weight < 0;})
+			== outcome.weights.end();
+	return outcome;
+}
+
+std::string EngineHarness::check_scheduling(const Outcome &outcome) {
+	const unsigned int num_vertices = outcome.scheduling.size();
+	const std::vector<Edge> &edges = outcome.edges;
+	std::vector<std::vector<int> > out(num_vertices);
+	std::vector<std::vector<int> > in(num_vertices);
+	for (unsigned int e = 0; e < edges.size(); e++) {
+		out[edges[e].first].push_back(e);
+		in[edges[e].second].push_back(e);
+	}
+
+	/*
+	 * an edge that does not go forward in program order must be the end of
+	 * an iteration: it carries a flip flop in the input graph and its head
+	 * reaches its tail. If some edge is not, the graph is not checked.
+	 */
+	std::vector<bool> back(edges.size(), false);
+	for (unsigned int e = 0; e < edges.size(); e++) {
+		const int u = edges[e].first;
+		const int v = edges[e].second;
+		if (v == SOURCE) {
+			back[e] = true;
+		} else if (v <= u) {
+			if (outcome.input_weights[e] == 0 || !reaches(v, u, out, edges)) {
+				return "";
+			}
+			back[e] = true;
+		}
+	}
+
+	std::vector<bool> reachable(num_vertices, false);
+	std::vector<int> queue(1, SOURCE);
+	reachable[SOURCE] = true;
+	for (unsigned int k = 0; k < queue.size(); k++) {
+		for (auto e : out[queue[k]]) {
+			if (!reachable[edges[e].second]) {
+				reachable[edges[e].second] = true;
+				queue.push_back(edges[e].second);
+			}
+		}
+	}
+
+	/*
+	 * the remaining edges go to a later vertex, so the vertices in index
+	 * order are a topological order. The source is scheduled after its own
+	 * delay and the unreachable vertices are never run, so they stay at 0.
+	 */
+	std::vector<int> step(num_vertices, 0);
+	step[SOURCE] = outcome.entry_delay;
+	std::vector<int> profile(step[SOURCE] + 1, 0);
+	profile[step[SOURCE]]++;
+	for (unsigned int v = SOURCE + 1; v < num_vertices; v++) {
+		if (!reachable[v]) {
+			continue;
+		}
+		bool reached = false;
+		for (auto e : in[v]) {
+			const int u = edges[e].first;
+			if (!back[e] && reachable[u]) {
+				step[v] = std::max(step[v], step[u] + outcome.weights[e]);
+				reached = true;
+			}
+		}
+		if (!reached) {
+			// a loop entered above its lowest vertex
+			return "";
+		}
+		if (step[v] >= (int) profile.size()) {
+			profile.resize(step[v] + 1, 0);
+		}
+		profile[step[v]]++;
+	}
+	checked_schedulings++;
+	if (step != outcome.scheduling) {
+		return "different scheduling";
+	}
+	if (profile != outcome.parallelism_profile) {
+		return "different parallelism profile";
+	}
+	return "";
+}
+
+std::string EngineHarness::compare_masks(const ManagerFactory &make,
+		int clock_period, const Outcome &reference, bool timed) {
+	// repeated and unsorted periods, the largest is the required one
+	std::vector<int> periods = { clock_period, clock_period - 1, clock_period
+			- 2, clock_period - 4, 1, clock_period };
+	for (auto &period : periods) {
+		period = std::max(period, 1);
+	}
+	RetimingManager rm = make(clock_period);
+	rm.set_num_threads(HARNESS_THREADS);
+	std::vector<bool> feasible;
+	std::vector<unsigned long> critical_pairs;
+	std::vector<unsigned long> relaxed_pairs;
+	const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	try {
+		feasible = rm.evaluate_clock_periods(periods, critical_pairs,
+				relaxed_pairs);
+	} catch (const char *msg) {
+		record_time(timed ? CRITICALITY_MASKS : UNTIMED, start);
+		return msg;
+	}
+	record_time(timed ? CRITICALITY_MASKS : UNTIMED, start);
+	if (flatten(rm.get_pc_matrix()) != reference.pc) {
+		return "different pC matrix";
+	}
+
+	for (unsigned int i = 0; i < periods.size(); i++) {
+		const int period = periods[i];
+		int lower = 0;
+		for (auto other : periods) {
+			if (other < period) {
+				lower = std::max(lower, other);
+			}
+		}
+		unsigned long critical = 0;
+		unsigned long relaxed = 0;
+		for (auto delay : reference.d) {
+			critical += delay > period;
+			relaxed += delay > lower && delay <= period && lower > 0;
+		}
+		const Outcome outcome = period == clock_period ?
+				reference :
+				run_retiming(make, period, false, false, 1, UNTIMED);
+		const std::string at = " at clock period " + std::to_string(period);
+		if (!outcome.error.empty()) {
+			return "reference: " + outcome.error + at;
+		} else if (feasible[i] != outcome.feasible) {
+			return "different feasibility" + at;
+		} else if (critical_pairs[i] != critical) {
+			return "different number of critical pairs" + at;
+		} else if (relaxed_pairs[i] != relaxed) {
+			return "different number of relaxed pairs" + at;
+		}
+	}
+	return "";
+}
+
+std::string EngineHarness::compare_errors(const ManagerFactory &make,
+		int clock_period, const Outcome &reference) {
+	for (int engine = REGIONS; engine <= REGIONS_PARALLEL_SOLVER; engine++) {
+		const Outcome outcome = run_retiming(make, clock_period,
+				engine != PARALLEL_SOLVER, engine != REGIONS, HARNESS_THREADS,
+				UNTIMED);
+		if (outcome.error != reference.error) {
+			return std::string(ENGINE_NAMES[engine]) + ": \"" + outcome.error
+					+ "\" instead of \"" + reference.error + "\"";
+		}
+	}
+	std::string error;
+	try {
+		RetimingManager rm = make(clock_period);
+		rm.set_num_threads(HARNESS_THREADS);
+		rm.evaluate_clock_periods(std::vector<int>(1, clock_period));
+	} catch (const char *msg) {
+		error = msg;
+	}
+	if (error != reference.error) {
+		return std::string(ENGINE_NAMES[CRITICALITY_MASKS]) + ": \"" + error
+				+ "\" instead of \"" + reference.error + "\"";
+	}
+	return "";
+}
+
+std::string EngineHarness::compare(const ManagerFactory &make,
+		int clock_period, bool timed, bool &skip) {
+	// the engines warn about the periods they cannot meet
+	std::streambuf *err = std::cerr.rdbuf(nullptr);
+	skip = false;
+	const Outcome reference = run_retiming(make, clock_period, false, false, 1,
+			timed ? REFERENCE : UNTIMED);
+	std::string difference;
+	if (!reference.error.empty()) {
+		// a graph the reference cannot retime is not compared
+		difference = compare_errors(make, clock_period, reference);
+		skip = difference.empty();
+		std::cerr.rdbuf(err);
+		return difference;
+	}
+	if (!reference.legal) {
+		std::cerr.rdbuf(err);
+		return "reference: negative weights";
+	}
+	difference = check_scheduling(reference);
+	if (!difference.empty()) {
+		std::cerr.rdbuf(err);
+		return "reference: " + difference;
+	}
+
+	for (int engine = REGIONS;
+			engine <= REGIONS_PARALLEL_SOLVER && difference.empty(); engine++) {
+		const Outcome outcome = run_retiming(make, clock_period,
+				engine != PARALLEL_SOLVER, engine != REGIONS, HARNESS_THREADS,
+				timed ? engine : UNTIMED);
+		if (!outcome.error.empty()) {
+			difference = outcome.error;
+		} else if (outcome.w != reference.w) {
+			difference = "different W matrix";
+		} else if (outcome.d != reference.d) {
+			difference = "different D matrix";
+		} else if (outcome.pc != reference.pc) {
+			difference = "different pC matrix";
+		} else if (!outcome.legal) {
+			difference = "negative weights";
+		} else if (outcome.feasible != reference.feasible) {
+			difference = "different feasibility";
+		} else if (outcome.weights != reference.weights) {
+			difference = "different retimed weights";
+		} else if (outcome.scheduling != reference.scheduling) {
+			difference = "different scheduling";
+		}
+		if (!difference.empty()) {
+			difference = std::string(ENGINE_NAMES[engine]) + ": " + difference;
+		}
+	}
+
+	if (difference.empty()) {
+		RetimingManager rm = make(clock_period);
+		const int side = std::sqrt(reference.w.size());
+		const std::chrono::steady_clock::time_point start =
+				std::chrono::steady_clock::now();
+		for (int u = 0; u < side && difference.empty(); u++) {
+			for (int v = 0; v < side; v++) {
+				const iPair w_d = rm.query_w_d(u, v);
+				if (w_d.first != reference.w[u * side + v]
+						|| w_d.second != reference.d[u * side + v]) {
+					difference = std::string(ENGINE_NAMES[POINT_QUERIES])
+							+ ": different W or D of " + std::to_string(u)
+							+ " " + std::to_string(v);
+					break;
+				}
+			}
+		}
+		record_time(timed ? POINT_QUERIES : UNTIMED, start);
+	}
+
+	if (difference.empty()) {
+		difference = compare_masks(make, clock_period, reference, timed);
+		if (!difference.empty()) {
+			difference = std::string(ENGINE_NAMES[CRITICALITY_MASKS]) + ": "
+					+ difference;
+		}
+	}
+	std::cerr.rdbuf(err);
+	return difference;
+}
+
+bool EngineHarness::run_input_file(std::string filename) {
+	bool passed = true;
+	for (const KnownScheduling &known : KNOWN_SCHEDULINGS) {
+		const std::string name = known.filename;
+		if (filename.size() < name.size()
+				|| filename.compare(filename.size() - name.size(),
+						name.size(), name) != 0) {
+			continue;
+		}
+		cases++;
+		if (RetimingManager(filename, 1, 1).get_scheduling()
+				!= known.scheduling) {
+			failures++;
+			passed = false;
+			std::cout << filename << ": different scheduling of the input graph"
+					<< std::endl;
+		}
+	}
+	for (int control_steps = 1; control_steps <= 2; control_steps++) {
+		const int input_clock_period = RetimingManager(filename,
+				control_steps, 1).compute_clock_period();
+		for (int clock_period = 1; clock_period <= input_clock_period;
+				clock_period++) {
+			const ManagerFactory make = [&](int period) {
+				return RetimingManager(filename, control_steps, period);
+			};
+			bool skip;
+			const std::string difference = compare(make, clock_period, true,
+					skip);
+			if (skip) {
+				skipped++;
+				continue;
+			}
+			cases++;
+			if (!difference.empty()) {
+				failures++;
+				passed = false;
+				std::cout << filename << " " << control_steps << " "
+						<< clock_period << ": " << difference << std::endl;
+			}
+		}
+	}
+	return passed;
+}
+
+bool EngineHarness::run_random(unsigned int count, unsigned int seed) {
+	std::mt19937 generator(seed);
+	bool passed = true;
+	for (unsigned int it = 0; it < count; it++) {
+		/*
+		 * every loop is a region reached from the entry node: forward edges
+		 * go to a later position, back edges to a previous one and always
+		 * have a flip flop, so there are no combinatorial cycles. The
+		 * vertex at position i of the loop is base + position[i], and the
+		 * loop is entered at any position. In half of the graphs the loops
+		 * are in program order instead: they are entered at their lowest
+		 * vertex and each position has an edge to the next one, so that
+		 * their scheduling is checked by check_scheduling().
+		 */
+		HarnessCase c;
+		c.delays.push_back(0);
+		const bool large = it % LARGE_GRAPH_RATE == LARGE_GRAPH_RATE - 1;
+		const bool program_order = generator() % 2 == 0;
+		const unsigned int num_loops = large ? 1 : 1 + generator() % 4;
+		for (unsigned int l = 0; l < num_loops; l++) {
+			const int base = c.delays.size();
+			const int size = large ? 256 + generator() % 45 : 1 + generator() % 8;
+			// about two edges leave each vertex of a large loop
+			const int sparsity = large ? size / 2 : 3;
+			std::vector<int> position(size);
+			for (int i = 0; i < size; i++) {
+				c.delays.push_back(1 + generator() % 3);
+				position[i] = base + i;
+			}
+			if (!program_order) {
+				std::shuffle(position.begin(), position.end(), generator);
+			}
+			c.edges.push_back(
+					Edge(SOURCE,
+							position[program_order ? 0 : generator() % size]));
+			c.weights.push_back(0);
+			for (int i = 0; i < size; i++) {
+				for (int j = 0; j < size; j++) {
+					if (i == j || ((!program_order || j != i + 1)
+							&& generator() % sparsity != 0)) {
+						continue;
+					}
+					c.edges.push_back(Edge(position[i], position[j]));
+					c.weights.push_back(
+							i < j ? generator() % 4 == 0 : 1 + generator() % 2);
+				}
+			}
+		}
+		// the order of the out edges of a vertex must not matter
+		std::vector<int> order(c.edges.size());
+		for (unsigned int e = 0; e < order.size(); e++) {
+			order[e] = e;
+		}
+		std::shuffle(order.begin(), order.end(), generator);
+		const HarnessCase generated = c;
+		for (unsigned int e = 0; e < order.size(); e++) {
+			c.edges[e] = generated.edges[order[e]];
+			c.weights[e] = generated.weights[order[e]];
+		}
+		c.control_steps = 1 + generator() % 3;
+		c.clock_period = 1 + generator() % 10;
+		if (!run_case(c)) {
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+bool EngineHarness::run_case(const HarnessCase &c) {
+	const ManagerFactory make = [&](int period) {
+		return RetimingManager(c.delays, c.edges, c.weights, c.control_steps,
+				period);
+	};
+	bool skip;
+	if (compare(make, c.clock_period, true, skip).empty()) {
+		if (skip) {
+			skipped++;
+		} else {
+			cases++;
+		}
+		return true;
+	}
+	cases++;
+	failures++;
+	const HarnessCase reproducer = shrink(c);
+	const std::string filename = reproducer_dir + "reproducer_"
+			+ std::to_string(failures) + ".txt";
+	write_case(reproducer, filename);
+	const ManagerFactory make_reproducer = [&](int period) {
+		return RetimingManager(reproducer.delays, reproducer.edges,
+				reproducer.weights, reproducer.control_steps, period);
+	};
+	std::cout << filename << " " << reproducer.control_steps << " "
+			<< reproducer.clock_period << ": "
+			<< compare(make_reproducer, reproducer.clock_period, false, skip)
+			<< std::endl;
+	return false;
+}
+
+HarnessCase EngineHarness::shrink(HarnessCase c) {
+	HarnessCase candidate;
+	const ManagerFactory make = [&](int period) {
+		return RetimingManager(candidate.delays, candidate.edges,
+				candidate.weights, candidate.control_steps, period);
+	};
+	/*
+	 * a candidate that no engine can retime is skipped by compare(), so it
+	 * is kept only if the engines fail in different ways
+	 */
+	bool skip;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		// the graph input file needs at least one edge
+		for (int e = c.edges.size() - 1; e >= 0 && c.edges.size() > 1; e--) {
+			candidate = c;
+			candidate.edges.erase(candidate.edges.begin() + e);
+			candidate.weights.erase(candidate.weights.begin() + e);
+			if (!compare(make, candidate.clock_period, false, skip).empty()) {
+				c = candidate;
+				changed = true;
+			}
+		}
+		for (int v = c.delays.size() - 1; v > SOURCE; v--) {
+			candidate = c;
+			candidate.delays.erase(candidate.delays.begin() + v);
+			candidate.edges.clear();
+			candidate.weights.clear();
+			for (unsigned int e = 0; e < c.edges.size(); e++) {
+				if (c.edges[e].first == v || c.edges[e].second == v) {
+					continue;
+				}
+				candidate.edges.push_back(
+						Edge(c.edges[e].first - (c.edges[e].first > v),
+								c.edges[e].second - (c.edges[e].second > v)));
+				candidate.weights.push_back(c.weights[e]);
+			}
+			if (!compare(make, candidate.clock_period, false, skip).empty()) {
+				c = candidate;
+				changed = true;
+			}
+		}
+	}
+	return c;
+}
+
+void EngineHarness::write_case(const HarnessCase &c,
+		std::string filename) const {
+	std::ofstream myfile;
+	myfile.open(filename);
+	for (auto delay : c.delays) {
+		myfile << delay << " ";
+	}
+	for (unsigned int e = 0; e < c.edges.size(); e++) {
+		myfile << std::endl << c.edges[e].first << " " << c.edges[e].second
+				<< " " << c.weights[e];
+	}
+	myfile.close();
+}
+
+void EngineHarness::print_report() const {
+	std::cout << "graphs: " << cases << ", failed: " << failures
+			<< ", skipped: " << skipped << ", schedulings checked: "
+			<< checked_schedulings << std::endl;
+	for (int engine = 0; engine < NUM_ENGINES; engine++) {
+		std::cout << std::left << std::setw(28) << ENGINE_NAMES[engine]
+				<< std::right << std::fixed << std::setprecision(3)
+				<< std::setw(10) << engine_seconds[engine] << " s"
+				<< std::endl;
+	}
+}
+
+unsigned int EngineHarness::get_failures() const {
+	return failures;
+}
@@ -1,19 +1,40 @@
 #include "RetimingManager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <iterator>
 #include <fstream>
-#include <list>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #include <boost/graph/bellman_ford_shortest_paths.hpp>
-#include <bits/stdc++.h> // for priority queue
+#include <boost/graph/filtered_graph.hpp>
+#include <boost/graph/strong_components.hpp>
+
+// number of rows of W and D kept for the point to point queries
+#define ROW_CACHE_CAPACITY 8
+
+// minimum number of rows of a matrix for which they are split among threads
+#define PARALLEL_MIN_SIDE 256
 
 RetimingManager::RetimingManager(const std::string filename, int control_steps,
-		int clock_period) {
+		int clock_period) :
+		row_cache(ROW_CACHE_CAPACITY) {
 	this->clock_period = clock_period;
-	pc_graph = nullptr;
+	input_clock_period = -1;
+	achieved_clock_period = -1;
+	region_decomposition = true;
+	parallel_pc_solver = true;
+	num_threads = 0;
+	time_budget = std::chrono::milliseconds(0);
+	decomposed = false;
 	std::ifstream infile(filename);
 	if (!infile) {
-		std::cerr << "file not found" << std::endl;
+		throw "file not found";
 	}
 	std::string first_line;
 	std::getline(infile, first_line);
@@ -27,17 +48,110 @@ RetimingManager::RetimingManager(const std::string filename, int control_steps,
 	while (s >> delay) {
 		delays.push_back(delay);
 	}
-	const unsigned int num_vertices = delays.size();
 
 	std::vector<int> weights;
 	std::vector<Edge> edges;
 	read_edges(infile, weights, edges, control_steps);
+	build_main_graph(edges, weights);
+	set_control_steps(control_steps);
+	restore_input_weights();
+}
+
+RetimingManager::RetimingManager(const std::vector<int> &delays,
+		const std::vector<Edge> &edges, const std::vector<int> &weights,
+		int control_steps, int clock_period) :
+		delays(delays), row_cache(ROW_CACHE_CAPACITY) {
+	if (weights.size() != edges.size()) {
+		throw "the number of weights is different from the number of edges";
+	}
+	this->clock_period = clock_period;
+	input_clock_period = -1;
+	achieved_clock_period = -1;
+	region_decomposition = true;
+	parallel_pc_solver = true;
+	num_threads = 0;
+	time_budget = std::chrono::milliseconds(0);
+	decomposed = false;
+	build_main_graph(edges, weights);
+	set_control_steps(control_steps);
+	restore_input_weights();
+}
+
+RetimingManager::RetimingManager(const std::vector<int> &delays,
+		const std::vector<Edge> &edges, int control_steps, int clock_period) :
+		RetimingManager(delays, edges, std::vector<int>(edges.size(), 0),
+				control_steps, clock_period) {
+}
+
+RetimingManager::RetimingManager() :
+		row_cache(ROW_CACHE_CAPACITY) {
+	clock_period = 0;
+	input_clock_period = -1;
+	achieved_clock_period = -1;
+	region_decomposition = true;
+	parallel_pc_solver = true;
+	num_threads = 0;
+	time_budget = std::chrono::milliseconds(0);
+	decomposed = false;
+}
+
+void RetimingManager::build_main_graph(const std::vector<Edge> &edges,
+		const std::vector<int> &weights) {
+	if (delays.empty()) {
+		throw "the graph must contain at least the entry node";
+	}
+	for (unsigned int k = 0; k < edges.size(); k++) {
+		if (edges[k].first < 0 || edges[k].first >= (int) delays.size()
+				|| edges[k].second < 0
+				|| edges[k].second >= (int) delays.size()) {
+			throw "an edge has a vertex that is not in the graph";
+		}
+	}
+	main_graph.reset(
+			new Graph(edges.begin(), edges.end(), weights.begin(),
+					delays.size()));
+
+	const weights_map graph_weights = get(boost::edge_weight, *main_graph);
+	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
+	input_weights.clear();
+	input_weights.reserve(edges.size());
+	for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+			++ei) {
+		input_weights.push_back(boost::get(graph_weights, *ei));
+	}
+
+	build_topological_order();
+	build_regions();
+}
+
+void RetimingManager::set_control_steps(int control_steps) {
+	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
+	unsigned int k = 0;
+	for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+			++ei, ++k) {
+		if (boost::source(*ei, *main_graph) == SOURCE) { // edge outgoing from entry
+			input_weights[k] = control_steps;
+		}
+	}
+}
+
+void RetimingManager::restore_input_weights() {
+	row_cache.clear();
+	const weights_map weights = get(boost::edge_weight, *main_graph);
+	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
+	unsigned int k = 0;
+	for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+			++ei, ++k) {
+		boost::put(weights, *ei, input_weights[k]);
+	}
+}
 
-	main_graph = new Graph(&edges[0], &edges[edges.size()], &weights[0],
-			num_vertices);
-	w = new SquareMatrix(num_vertices, INF);
-	d = new SquareMatrix(num_vertices, 0);
-	pc = new SquareMatrix(num_vertices);
+void RetimingManager::reset(int clock_period, int control_steps) {
+	this->clock_period = clock_period;
+	input_clock_period = -1;
+	achieved_clock_period = -1;
+	set_control_steps(control_steps);
+	restore_input_weights();
 }
 
 void RetimingManager::read_edges(std::ifstream &infile,
@@ -51,6 +165,10 @@ void RetimingManager::read_edges(std::ifstream &infile,
 	std::vector<int> values((std::istream_iterator<int>(stream)), // begin
 			(std::istream_iterator<int>()));      // end
 
+	if (values.size() < 2) {
+		throw "the input file must contain at least one edge";
+	}
+
 	int tail_node, head_node;
 	tail_node = values[0];
 	head_node = values[1];
@@ -79,14 +197,111 @@ void RetimingManager::read_edges(std::ifstream &infile,
 	}
 }
 
-void RetimingManager::apply_retiming() {
+void RetimingManager::run_measured(const std::function<bool()> &run) {
 	if (is_main_graph_cyclic()) {
 		throw "input graph contains cycles, you cannot apply retiming.";
 	}
-	build_w_d_matrices();
-	build_pc_matrix();
-	build_pc_graph();
-	apply_final_step();
+	start_time = std::chrono::steady_clock::now();
+	deadline = start_time + time_budget;
+	stats = RetimingStats();
+	decomposed = region_decomposition && region_vertices.size() > 1;
+	try {
+		stats.completed = run();
+	} catch (const char *msg) {
+		stats.elapsed_seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start_time).count();
+		throw;
+	}
+	stats.elapsed_seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start_time).count();
+}
+
+void RetimingManager::apply_retiming() {
+	input_clock_period = -1;
+	achieved_clock_period = -1;
+	run_measured([&]() {
+		input_clock_period = compute_clock_period();
+		if (decomposed) {
+			return apply_retiming_by_region();
+		}
+		build_matrices(true, count_threads(delays.size()));
+		return apply_final_step();
+	});
+	if (!stats.completed) {
+		return;
+	}
+	achieved_clock_period = compute_clock_period();
+	if (achieved_clock_period > clock_period) {
+		std::cerr << "RETIMED GRAPH HAS CLOCK PERIOD " << achieved_clock_period
+				<< ", GREATER THAN THE REQUIRED " << clock_period << std::endl;
+	}
+}
+
+std::vector<bool> RetimingManager::evaluate_clock_periods(
+		const std::vector<int> &periods) {
+	std::vector<unsigned long> critical_pairs;
+	std::vector<unsigned long> relaxed_pairs;
+	return evaluate_clock_periods(periods, critical_pairs, relaxed_pairs);
+}
+
+std::vector<bool> RetimingManager::evaluate_clock_periods(
+		const std::vector<int> &periods,
+		std::vector<unsigned long> &critical_pairs,
+		std::vector<unsigned long> &relaxed_pairs) {
+	std::vector<bool> feasible;
+	critical_pairs.assign(periods.size(), 0);
+	relaxed_pairs.assign(periods.size(), 0);
+	run_measured([&]() {
+		if (!decomposed) {
+			feasible = evaluate_masks(periods, critical_pairs, relaxed_pairs);
+			return true;
+		}
+		/*
+		 * a period is feasible if and only if it is feasible in every
+		 * region, and a pair of vertices of different regions is never
+		 * critical, so the counts are the sums over the regions
+		 */
+		load_regions();
+		feasible.assign(periods.size(), true);
+		report_progress("regions", 0, regions.size());
+		for (unsigned int k = 0; k < regions.size(); k++) {
+			const std::vector<bool> region_feasible =
+					regions[k]->evaluate_masks(periods, critical_pairs,
+							relaxed_pairs);
+			for (unsigned int i = 0; i < periods.size(); i++) {
+				feasible[i] = feasible[i] && region_feasible[i];
+			}
+			report_progress("regions", k + 1, regions.size());
+		}
+		return true;
+	});
+	return feasible;
+}
+
+std::vector<bool> RetimingManager::evaluate_masks(
+		const std::vector<int> &periods,
+		std::vector<unsigned long> &critical_pairs,
+		std::vector<unsigned long> &relaxed_pairs) {
+	build_matrices(false, count_threads(delays.size()));
+	const CriticalityMasks masks(*d, periods);
+	std::vector<bool> feasible_masks(masks.get_num_periods());
+	std::vector<int> pc_distances;
+	for (unsigned int k = 0; k < masks.get_num_periods(); k++) {
+		build_pc_matrix(masks, k);
+		feasible_masks[k] = solve_pc(pc_distances,
+				count_threads(delays.size()));
+		report_progress("clock periods", k + 1, masks.get_num_periods());
+	}
+	std::vector<bool> feasible(periods.size());
+	for (unsigned int i = 0; i < periods.size(); i++) {
+		const unsigned int k = masks.get_index(periods[i]);
+		feasible[i] = feasible_masks[k];
+		critical_pairs[i] += masks.count_critical(k);
+		if (k > 0) {
+			relaxed_pairs[i] += masks.count_difference(k - 1, k);
+		}
+	}
+	return feasible;
 }
 
 void swap(RetimingManager& first, RetimingManager& second) {
@@ -98,33 +313,74 @@ void swap(RetimingManager& first, RetimingManager& second) {
 	swap(first.main_graph, second.main_graph);
 	swap(first.pc_graph, second.pc_graph);
 	swap(first.delays, second.delays);
+	swap(first.input_weights, second.input_weights);
+	swap(first.topological_order, second.topological_order);
+	swap(first.loop_component, second.loop_component);
+	swap(first.program_ordered, second.program_ordered);
+	swap(first.discover_time, second.discover_time);
+	swap(first.finish_time, second.finish_time);
+	swap(first.region_decomposition, second.region_decomposition);
+	swap(first.parallel_pc_solver, second.parallel_pc_solver);
+	swap(first.num_threads, second.num_threads);
+	swap(first.progress_callback, second.progress_callback);
+	swap(first.cancellation_token, second.cancellation_token);
+	swap(first.time_budget, second.time_budget);
+	swap(first.start_time, second.start_time);
+	swap(first.deadline, second.deadline);
+	swap(first.stats, second.stats);
+	swap(first.decomposed, second.decomposed);
+	swap(first.region_vertices, second.region_vertices);
+	swap(first.vertex_region, second.vertex_region);
+	swap(first.regions, second.regions);
+	swap(first.row_cache, second.row_cache);
+	swap(first.query_workspace, second.query_workspace);
+	swap(first.query_dist, second.query_dist);
+	swap(first.query_delays, second.query_delays);
 	swap(first.clock_period, second.clock_period);
+	swap(first.input_clock_period, second.input_clock_period);
+	swap(first.achieved_clock_period, second.achieved_clock_period);
 	swap(first.w, second.w);
 	swap(first.d, second.d);
 	swap(first.pc, second.pc);
 }
 
-RetimingManager& RetimingManager::operator=(RetimingManager other) {
+RetimingManager& RetimingManager::operator=(RetimingManager&& other) {
 	swap(*this, other);
 	return *this;
 }
 
-RetimingManager::RetimingManager(const RetimingManager & other) :
-		delays(other.delays) {
-	main_graph = new Graph(*(other.main_graph));
-	pc_graph = new DenseGraph(*(other.pc_graph));
-	clock_period = other.clock_period;
-	w = new SquareMatrix(*(other.w));
-	d = new SquareMatrix(*(other.d));
-	pc = new SquareMatrix(*(other.pc));
+RetimingManager::RetimingManager(RetimingManager&& other) :
+		main_graph(std::move(other.main_graph)), delays(
+				std::move(other.delays)), input_weights(
+				std::move(other.input_weights)), w(std::move(other.w)), d(
+				std::move(other.d)), pc(std::move(other.pc)), pc_graph(
+				std::move(other.pc_graph)), topological_order(
+				std::move(other.topological_order)), loop_component(
+				std::move(other.loop_component)), program_ordered(
+				std::move(other.program_ordered)), discover_time(
+				std::move(other.discover_time)), finish_time(
+				std::move(other.finish_time)), region_decomposition(
+				other.region_decomposition), parallel_pc_solver(
+				other.parallel_pc_solver), num_threads(
+				other.num_threads), progress_callback(
+				std::move(other.progress_callback)), cancellation_token(
+				std::move(other.cancellation_token)), time_budget(
+				other.time_budget), start_time(other.start_time), deadline(
+				other.deadline), stats(other.stats), decomposed(
+				other.decomposed), region_vertices(
+				std::move(other.region_vertices)), vertex_region(
+				std::move(other.vertex_region)), regions(
+				std::move(other.regions)), row_cache(
+				std::move(other.row_cache)), query_workspace(
+				std::move(other.query_workspace)), query_dist(
+				std::move(other.query_dist)), query_delays(
+				std::move(other.query_delays)), clock_period(
+				other.clock_period), input_clock_period(
+				other.input_clock_period), achieved_clock_period(
+				other.achieved_clock_period) {
 }
 
 RetimingManager::~RetimingManager() {
-	delete main_graph;
-	delete pc_graph;
-	delete w;
-	delete d;
-	delete pc;
 }
 
 void RetimingManager::print_main_graph() const {
@@ -153,68 +409,76 @@ void RetimingManager::print_main_graph() const {
 }
 
 SquareMatrix RetimingManager::get_w_matrix() const {
-	return *w;
+	return assemble_matrix(&RetimingManager::w, INF);
 }
 
 SquareMatrix RetimingManager::get_d_matrix() const {
-	return *d;
+	return assemble_matrix(&RetimingManager::d, 0);
 }
 
 SquareMatrix RetimingManager::get_pc_matrix() const {
-	return *pc;
+	return assemble_matrix(&RetimingManager::pc, INF);
 }
 
-/**
- * Tells if node v is in the path between src and end, where the structure
- * of the tree is described by the parent array
- * @param v the node that you want to check if it is in the path
- * @param src the source node
- * @param end the end node
- * @param parent the parent array, that contains the tree
- * @return
- */
-bool isInPath(int v, int src, int end, int parent[]) {
-	int i = end;
-	if (v == src || v == end) {
-		return true;
+SquareMatrix RetimingManager::assemble_matrix(
+		std::unique_ptr<SquareMatrix> RetimingManager::*matrix,
+		int default_value) const {
+	SquareMatrix result(delays.size(), default_value);
+	if (!decomposed) {
+		if (this->*matrix) {
+			result = *(this->*matrix);
+		}
+		return result;
 	}
-	while (parent[i] != -1) {
-		if (v == parent[i]) {
-			return true;
+	// pairs of vertices of different regions are not connected
+	for (unsigned int k = 0; k < regions.size(); k++) {
+		const SquareMatrix &region_matrix = *(regions[k].get()->*matrix);
+		const std::vector<int> &global = region_vertices[k];
+		for (unsigned int i = 0; i < global.size(); i++) {
+			for (unsigned int j = 0; j < global.size(); j++) {
+				result.set(global[i], global[j], region_matrix.get(i, j));
+			}
 		}
-		i = parent[i];
 	}
-	return false;
+	return result;
 }
 
-void RetimingManager::dijkstra_max_delay(int src, int* dist, int* tot_delays) {
+int RetimingManager::dijkstra_max_delay(int src, int* dist, int* tot_delays,
+		DijkstraWorkspace &workspace, int target) {
 	const weights_map weights = get(boost::edge_weight, *main_graph);
 
 	/*
-	 * Value of parent[v] for a vertex v stores parent vertex of v in
-	 * shortest path tree. Parent of root (or source vertex) is -1.
+	 * The parent of a vertex v stores parent vertex of v in shortest path
+	 * tree. Parent of root (or source vertex) is -1.
 	 * Whenever we find shorter path through a vertex u, we make u as
 	 * parent of current vertex.
+	 * The workspace priority queue stores vertices that are being
+	 * preprocessed.
 	 */
-	int parent[num_vertices(*main_graph)];
-
-	// Create a priority queue to store vertices that are being preprocessed
-	std::priority_queue<iPair, std::vector<iPair>, std::greater<iPair> > pq;
+	workspace.reset();
 	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
 
 	// Insert source itself in priority queue and initialize its distance as 0.
-	pq.push(std::make_pair(0, src));
+	workspace.push(std::make_pair(0, src));
 	dist[src] = 0;
-	parent[src] = -1;
+	workspace.set_parent(src, -1);
 	tot_delays[src] = delays[src];
 
 	// Looping till priority queue becomes empty (or all distances are not finalized)
-	while (!pq.empty()) {
+	while (!workspace.empty()) {
+		if (target != -1 && workspace.top().first > dist[target]) {
+			/*
+			 * weights are not negative, so the vertices still in the queue
+			 * cannot improve the paths that are not longer than the one of
+			 * the target
+			 */
+			return dist[target];
+		}
+
 		// The first vertex in pair is the minimum distance
 		// vertex, extract it from priority queue.
 		// vertex label is stored in second of pair.
-		int u = pq.top().second;
-		pq.pop();
+		int u = workspace.pop().second;
 		typename GraphTraits::adjacency_iterator ai;
 		typename GraphTraits::adjacency_iterator ai_end;
 		typename GraphTraits::out_edge_iterator out_i, out_end;
@@ -229,71 +493,580 @@ void RetimingManager::dijkstra_max_delay(int src, int* dist, int* tot_delays) {
 			if (dist[v] > dist[u] + weight
 					|| (weight + dist[u] == dist[v]
 							&& delays[v] + tot_delays[u] > tot_delays[v])) {
-				if (!isInPath(v, src, u, parent)) {
+				if (!workspace.is_in_path(v, src, u)) {
 					// Updating total delay and distance of v
 					tot_delays[v] = delays[v] + tot_delays[u];
 					dist[v] = dist[u] + weight;
-					parent[v] = u;
-					pq.push(std::make_pair(dist[v], v));
+					workspace.set_parent(v, u);
+					workspace.push(std::make_pair(dist[v], v));
 				}
 			}
 		}
 	}
+	return INF;
 }
 
-void RetimingManager::build_w_d_matrices() {
-	for (unsigned int i = 0; i < w->get_side(); i++) {
-		dijkstra_max_delay(i, w->get()[i], d->get()[i]);
+iPair RetimingManager::query_w_d(int u, int v) {
+	const int num_vertices = delays.size();
+	if (u < 0 || u >= num_vertices || v < 0 || v >= num_vertices) {
+		throw "vertex out of range";
 	}
+	int w_uv, d_uv;
+	if (!row_cache.lookup(u, v, w_uv, d_uv)) {
+		if (!query_workspace) {
+			query_workspace.reset(new DijkstraWorkspace(num_vertices));
+		}
+		// no allocation if the buffers come from a replaced row
+		query_dist.assign(num_vertices, INF);
+		query_delays.assign(num_vertices, 0);
+		const int bound = dijkstra_max_delay(u, &query_dist[0],
+				&query_delays[0], *query_workspace, v);
+		w_uv = query_dist[v];
+		d_uv = query_delays[v];
+		row_cache.insert(u, bound, query_dist, query_delays);
+	}
+	return std::make_pair(w_uv, d_uv);
 }
 
-void RetimingManager::build_pc_matrix() {
-	for (unsigned int i = 0; i < d->get_side(); i++) {
-		for (unsigned int j = 0; j < d->get_side(); j++) {
-			if (d->get(i, j) > clock_period) {
-				pc->set(i, j, w->get(i, j) - 1);
-			} else {
-				pc->set(i, j, w->get(i, j));
+unsigned int RetimingManager::count_threads(unsigned int rows) const {
+	if (num_threads > 0) {
+		return std::max(1u, std::min(rows, num_threads));
+	}
+	return rows < PARALLEL_MIN_SIDE ?
+			1 :
+			std::min(rows, std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void RetimingManager::build_matrices(bool with_pc, unsigned int num_threads) {
+	const unsigned int side = delays.size();
+	if (!w) {
+		w.reset(new SquareMatrix(side));
+		d.reset(new SquareMatrix(side));
+	}
+	if (with_pc) {
+		allocate_pc();
+	}
+
+	std::atomic<unsigned int> next_row(0);
+	std::atomic<bool> aborted(false);
+	const char *abort_message = nullptr;
+	unsigned int rows_done = 0;
+	std::mutex progress_mutex;
+	auto worker = [&]() {
+		// allocated once and reused by the run of every source of the worker
+		DijkstraWorkspace workspace(side);
+		unsigned int i;
+		while (!aborted && (i = next_row++) < side) {
+			// a previous run may have filled the row
+			std::fill_n(w->get()[i], side, INF);
+			std::fill_n(d->get()[i], side, 0);
+			dijkstra_max_delay(i, w->get()[i], d->get()[i], workspace);
+			if (with_pc) {
+				// the row is final, so its constraints can be emitted now
+				build_pc_row(i);
+			}
+			// exceptions cannot leave a thread, so they are rethrown later
+			std::lock_guard<std::mutex> lock(progress_mutex);
+			try {
+				report_progress(
+						with_pc ? "W, D and pC matrices" : "W and D matrices",
+						++rows_done, side);
+			} catch (const char *msg) {
+				if (!abort_message) {
+					abort_message = msg;
+				}
+				aborted = true;
 			}
 		}
+	};
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < num_threads; t++) {
+		threads.push_back(std::thread(worker));
+	}
+	worker();
+	for (unsigned int t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+	if (abort_message) {
+		throw abort_message;
+	}
+}
+
+void RetimingManager::allocate_pc() {
+	if (!pc) {
+		pc.reset(new SquareMatrix(delays.size()));
+	}
+	if (!parallel_pc_solver) {
+		build_pc_graph();
+	}
+}
+
+void RetimingManager::build_pc_row(unsigned int i) {
+	const int *w_row = w->get()[i];
+	const int *d_row = d->get()[i];
+	int *pc_row = pc->get()[i];
+	for (unsigned int j = 0; j < pc->get_side(); j++) {
+		if (d_row[j] > clock_period) {
+			pc_row[j] = w_row[j] - 1;
+		} else {
+			pc_row[j] = w_row[j];
+		}
+	}
+	if (!parallel_pc_solver) {
+		update_pc_graph_row(i);
+	}
+}
+
+void RetimingManager::build_pc_matrix(const CriticalityMasks &masks,
+		unsigned int k) {
+	allocate_pc();
+	for (unsigned int i = 0; i < w->get_side(); i++) {
+		masks.build_pc_row(k, i, w->get()[i], pc->get()[i]);
+		if (!parallel_pc_solver) {
+			update_pc_graph_row(i);
+		}
 	}
 }
 
 void RetimingManager::build_pc_graph() {
+	if (pc_graph) {
+		// the graph has already the right edges
+		return;
+	}
 	const unsigned int num_vertices = boost::num_vertices(*main_graph) + 1;
-	std::vector<Edge> edges;
-	std::vector<int> weights;
-	unsigned int i;
-	for (i = 1; i < num_vertices; i++) {
-		edges.push_back(Edge(SOURCE, i));
-		weights.push_back(0);
+	const boost::property<boost::edge_weight_t, int> no_weight(0);
+	pc_graph.reset(new DenseGraph(num_vertices));
+	for (unsigned int i = 1; i < num_vertices; i++) {
+		boost::add_edge(SOURCE, i, no_weight, *pc_graph);
 	}
-	for (i = 0; i < boost::num_vertices(*main_graph); i++) {
-		for (unsigned int j = 0; j < boost::num_vertices(*main_graph); j++) {
-			edges.push_back(Edge(j + 1, i + 1));
-			weights.push_back(pc->get(i, j));
+	for (unsigned int i = 1; i < num_vertices; i++) {
+		for (unsigned int j = 1; j < num_vertices; j++) {
+			boost::add_edge(j, i, no_weight, *pc_graph);
 		}
 	}
-	pc_graph = new DenseGraph(&edges[0], &edges[edges.size()], &weights[0],
-			num_vertices);
 }
 
-void RetimingManager::apply_final_step() {
-	std::vector<int> pc_distances(boost::num_vertices(*pc_graph),
-			(std::numeric_limits<short>::max)());
+void RetimingManager::update_pc_graph_row(unsigned int i) {
+	// PC(i,j) is the weight of the edge which goes from node j to node i
+	for (unsigned int j = 0; j < pc->get_side(); j++) {
+		boost::put(boost::edge_weight_t(), *pc_graph,
+				boost::edge(j + 1, i + 1, *pc_graph).first, pc->get(i, j));
+	}
+}
+
+/**
+ * Bellman ford visitor that calls a function every time that all the edges
+ * of the graph have been examined, i.e. at the end of every round
+ */
+struct RoundVisitor: public boost::default_bellman_visitor {
+	RoundVisitor(const std::function<void()> *on_round,
+			unsigned long *examined_edges, unsigned long num_edges) :
+			on_round(on_round), examined_edges(examined_edges), num_edges(
+					num_edges) {
+	}
+	template<typename E, typename G>
+	void examine_edge(E, const G&) {
+		if (++*examined_edges % num_edges == 0) {
+			(*on_round)();
+		}
+	}
+	const std::function<void()> *on_round;
+	unsigned long *examined_edges;
+	unsigned long num_edges;
+};
+
+bool RetimingManager::solve_pc_graph(std::vector<int> &pc_distances) {
+	const unsigned int num_vertices = boost::num_vertices(*pc_graph);
+	pc_distances.assign(num_vertices, (std::numeric_limits<short>::max)());
 	pc_distances[SOURCE] = 0; // the source is at distance 0
-	const bool r = boost::bellman_ford_shortest_paths(*pc_graph,
-			boost::num_vertices(*pc_graph),
-			boost::distance_map(&pc_distances[0]));
+
+	unsigned long examined_edges = 0;
+	unsigned int round = 0;
+	const std::function<void()> on_round = [&]() {
+		report_progress("pC solver", ++round, num_vertices);
+	};
+	return boost::bellman_ford_shortest_paths(*pc_graph, num_vertices,
+			boost::distance_map(&pc_distances[0]).visitor(
+					RoundVisitor(&on_round, &examined_edges,
+							std::max<unsigned long>(1,
+									boost::num_edges(*pc_graph)))));
+}
+
+/**
+ * Reusable barrier: every call of wait() returns when count threads have
+ * called it, then the barrier is ready for the next round
+ */
+struct RoundBarrier {
+	explicit RoundBarrier(unsigned int count) :
+			count(count), waiting(0), generation(0) {
+	}
+
+	void wait() {
+		std::unique_lock<std::mutex> lock(mutex);
+		const unsigned long round = generation;
+		if (++waiting == count) {
+			waiting = 0;
+			generation++;
+			all_arrived.notify_all();
+		} else {
+			all_arrived.wait(lock, [&]() {return generation != round;});
+		}
+	}
+
+	const unsigned int count;
+	unsigned int waiting;
+	unsigned long generation;
+	std::mutex mutex;
+	std::condition_variable all_arrived;
+};
+
+bool RetimingManager::solve_pc_matrix(std::vector<int> &pc_distances,
+		unsigned int num_threads) {
+	const unsigned int side = pc->get_side();
+
+	/*
+	 * Jacobi version of bellman ford: in each round every vertex takes the
+	 * minimum over its incoming edges reading only the distances of the
+	 * previous round, so the rows of pC can be relaxed by different threads
+	 * and the result does not depend on the order.
+	 * The origin reaches every vertex with an edge of weight 0, so all the
+	 * distances start from 0.
+	 */
+	std::vector<int> current(side, 0);
+	std::vector<int> next(side);
+	std::atomic<bool> changed(false);
+	auto relax_rows = [&](unsigned int first, unsigned int last) {
+		bool rows_changed = false;
+		for (unsigned int i = first; i < last; i++) {
+			// PC(i,j) is the weight of the edge which goes from node j to node i
+			const int *row = pc->get()[i];
+			int best = current[i];
+			for (unsigned int j = 0; j < side; j++) {
+				if (current[j] + row[j] < best) {
+					best = current[j] + row[j];
+				}
+			}
+			next[i] = best;
+			rows_changed = rows_changed || best != current[i];
+		}
+		if (rows_changed) {
+			changed = true;
+		}
+	};
+
+	num_threads = std::max(1u, std::min(num_threads, side));
+	const unsigned int chunk = (side + num_threads - 1) / num_threads;
+
+	/*
+	 * The workers live for the whole solve. In each round they relax their
+	 * rows and wait for each other, then the calling thread (worker 0)
+	 * closes the round alone while the others wait for its decision.
+	 * Without negative cycles every shortest path has at most side edges
+	 * after the one from the origin, so a round without changes is reached
+	 * within side + 1 rounds.
+	 */
+	RoundBarrier barrier(num_threads);
+	bool stop = false;
+	bool converged = false;
+	const char *abort_message = nullptr;
+	auto worker = [&](unsigned int t) {
+		for (unsigned int round = 0; round <= side; round++) {
+			relax_rows(std::min(side, t * chunk),
+					std::min(side, (t + 1) * chunk));
+			barrier.wait();
+			if (t == 0) {
+				current.swap(next);
+				converged = !changed;
+				stop = converged || round == side;
+				changed = false;
+				// exceptions cannot leave a thread, so they are rethrown later
+				try {
+					report_progress("pC solver", round + 1, side + 1);
+				} catch (const char *msg) {
+					abort_message = msg;
+					stop = true;
+				}
+			}
+			barrier.wait();
+			if (stop) {
+				return;
+			}
+		}
+	};
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < num_threads; t++) {
+		threads.push_back(std::thread(worker, t));
+	}
+	worker(0);
+	for (unsigned int t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+	if (abort_message) {
+		throw abort_message;
+	}
+	if (!converged) {
+		return false;
+	}
+	// the origin is the vertex 0 of the pC graph
+	pc_distances.assign(1, 0);
+	pc_distances.insert(pc_distances.end(), current.begin(), current.end());
+	return true;
+}
+
+bool RetimingManager::solve_pc(std::vector<int> &pc_distances,
+		unsigned int num_threads) {
+	if (parallel_pc_solver) {
+		return solve_pc_matrix(pc_distances, num_threads);
+	}
+	return solve_pc_graph(pc_distances);
+}
+
+bool RetimingManager::apply_final_step() {
+	std::vector<int> pc_distances;
+	const bool r = solve_pc(pc_distances, count_threads(delays.size()));
 	if (!r) {
 		std::cerr << "PC_GRAPH CONTAINS NEGATIVE CYCLES, CANNOT APPLY RETIMING"
 				<< std::endl;
 	} else {
 		move_weights(pc_distances);
 	}
+	return r;
+}
+
+void RetimingManager::build_regions() {
+	const unsigned int num_vertices = delays.size();
+	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
+	region_vertices.clear();
+	vertex_region.assign(num_vertices, -1);
+	regions.clear();
+	if (num_vertices == 0 || boost::in_degree(SOURCE, *main_graph) > 0) {
+		// paths through the source would connect all the regions
+		return;
+	}
+
+	/*
+	 * the regions are the weakly connected components of the graph without
+	 * the source, found with a bfs that follows edges in both directions
+	 */
+	std::vector<int> queue;
+	queue.reserve(num_vertices);
+	for (unsigned int v = 0; v < num_vertices; v++) {
+		if (v == SOURCE || vertex_region[v] != -1) {
+			continue;
+		}
+		const int region = region_vertices.size();
+		queue.clear();
+		queue.push_back(v);
+		vertex_region[v] = region;
+		auto visit = [&](int t) {
+			if (t != SOURCE && vertex_region[t] == -1) {
+				vertex_region[t] = region;
+				queue.push_back(t);
+			}
+		};
+		for (unsigned int k = 0; k < queue.size(); k++) {
+			const int u = queue[k];
+			typename GraphTraits::out_edge_iterator out_i, out_end;
+			typename GraphTraits::in_edge_iterator in_i, in_end;
+			for (boost::tie(out_i, out_end) = boost::out_edges(u, *main_graph);
+					out_i != out_end; ++out_i) {
+				visit(index[boost::target(*out_i, *main_graph)]);
+			}
+			for (boost::tie(in_i, in_end) = boost::in_edges(u, *main_graph);
+					in_i != in_end; ++in_i) {
+				visit(index[boost::source(*in_i, *main_graph)]);
+			}
+		}
+		// the source is the first vertex of every region, then the vertices
+		// keep their relative order
+		std::sort(queue.begin(), queue.end());
+		region_vertices.push_back(std::vector<int>(1, SOURCE));
+		region_vertices.back().insert(region_vertices.back().end(),
+				queue.begin(), queue.end());
+	}
+}
+
+void RetimingManager::load_regions() {
+	const weights_map weights = get(boost::edge_weight, *main_graph);
+	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
+	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
+
+	if (regions.empty()) {
+		// index of each vertex in its region
+		std::vector<int> local(delays.size(), 0);
+		std::vector<std::vector<Edge> > region_edges(region_vertices.size());
+		std::vector<std::vector<int> > region_weights(region_vertices.size());
+		for (unsigned int k = 0; k < region_vertices.size(); k++) {
+			for (unsigned int i = 1; i < region_vertices[k].size(); i++) {
+				local[region_vertices[k][i]] = i;
+			}
+		}
+		for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+				++ei) {
+			const int u = index[boost::source(*ei, *main_graph)];
+			const int v = index[boost::target(*ei, *main_graph)];
+			region_edges[vertex_region[v]].push_back(Edge(local[u], local[v]));
+			region_weights[vertex_region[v]].push_back(0);
+		}
+		for (unsigned int k = 0; k < region_vertices.size(); k++) {
+			std::unique_ptr<RetimingManager> region(new RetimingManager());
+			for (unsigned int i = 0; i < region_vertices[k].size(); i++) {
+				region->delays.push_back(delays[region_vertices[k][i]]);
+			}
+			// a region cannot be split again
+			region->region_decomposition = false;
+			region->build_main_graph(region_edges[k], region_weights[k]);
+			regions.push_back(std::move(region));
+		}
+	}
+
+	/*
+	 * the edges of a region were inserted following the order of
+	 * boost::edges() on the main graph, and the region keeps the relative
+	 * order of the vertices, so its boost::edges() visits them in the same
+	 * order
+	 */
+	std::vector<unsigned int> next_edge(regions.size(), 0);
+	for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+			++ei) {
+		const int k = vertex_region[index[boost::target(*ei, *main_graph)]];
+		regions[k]->input_weights[next_edge[k]++] = boost::get(weights, *ei);
+	}
+	for (unsigned int k = 0; k < regions.size(); k++) {
+		regions[k]->clock_period = clock_period;
+		regions[k]->parallel_pc_solver = parallel_pc_solver;
+		regions[k]->num_threads = num_threads;
+		regions[k]->cancellation_token = cancellation_token;
+		regions[k]->time_budget = time_budget;
+		regions[k]->deadline = deadline;
+		regions[k]->restore_input_weights();
+	}
+}
+
+bool RetimingManager::apply_retiming_by_region() {
+	load_regions();
+
+	std::vector<std::vector<int> > region_distances(regions.size());
+	std::vector<char> solved(regions.size(), false);
+	std::atomic<unsigned int> next_region(0);
+	std::atomic<bool> aborted(false);
+	const char *abort_message = nullptr;
+	unsigned int regions_done = 0;
+	std::mutex progress_mutex;
+	report_progress("regions", 0, regions.size());
+	auto worker = [&]() {
+		unsigned int k;
+		while (!aborted && (k = next_region++) < regions.size()) {
+			// exceptions cannot leave a thread, so they are rethrown later
+			try {
+				// the regions are already run in parallel
+				regions[k]->build_matrices(true, 1);
+				solved[k] = regions[k]->solve_pc(region_distances[k], 1);
+				std::lock_guard<std::mutex> lock(progress_mutex);
+				report_progress("regions", ++regions_done, regions.size());
+			} catch (const char *msg) {
+				std::lock_guard<std::mutex> lock(progress_mutex);
+				if (!abort_message) {
+					abort_message = msg;
+				}
+				aborted = true;
+			}
+		}
+	};
+	const unsigned int num_region_threads = std::min<unsigned int>(
+			regions.size(),
+			num_threads > 0 ?
+					num_threads :
+					std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < num_region_threads; t++) {
+		threads.push_back(std::thread(worker));
+	}
+	worker();
+	for (unsigned int t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+	if (abort_message) {
+		// only the progress steps of the regions can stop them
+		stats.stopped = true;
+		throw abort_message;
+	}
+
+	if (std::find(solved.begin(), solved.end(), false) != solved.end()) {
+		std::cerr << "PC_GRAPH CONTAINS NEGATIVE CYCLES, CANNOT APPLY RETIMING"
+				<< std::endl;
+		return false;
+	}
+
+	/*
+	 * The source has no incoming edges, so in the pc graph it has no
+	 * outgoing edges: the distance of a vertex only depends on its region,
+	 * while the distance of the source is the minimum over all the regions.
+	 */
+	std::vector<int> pc_distances(delays.size() + 1, 0);
+	for (unsigned int k = 0; k < regions.size(); k++) {
+		pc_distances[SOURCE + 1] = std::min(pc_distances[SOURCE + 1],
+				region_distances[k][SOURCE + 1]);
+		for (unsigned int i = 1; i < region_vertices[k].size(); i++) {
+			pc_distances[region_vertices[k][i] + 1] = region_distances[k][i + 1];
+		}
+	}
+	move_weights(pc_distances);
+	return true;
+}
+
+void RetimingManager::set_region_decomposition(bool enabled) {
+	region_decomposition = enabled;
+}
+
+void RetimingManager::set_num_threads(unsigned int num_threads) {
+	this->num_threads = num_threads;
+}
+
+void RetimingManager::set_parallel_pc_solver(bool enabled) {
+	parallel_pc_solver = enabled;
+}
+
+void RetimingManager::set_progress_callback(ProgressCallback callback) {
+	progress_callback = callback;
+}
+
+void RetimingManager::set_cancellation_token(CancellationToken token) {
+	cancellation_token = token;
+}
+
+void RetimingManager::set_time_budget(std::chrono::milliseconds budget) {
+	time_budget = budget;
+}
+
+RetimingStats RetimingManager::get_stats() const {
+	return stats;
+}
+
+void RetimingManager::report_progress(const char *phase, unsigned int done,
+		unsigned int total) {
+	const std::chrono::steady_clock::time_point now =
+			std::chrono::steady_clock::now();
+	stats.phase = phase;
+	stats.done = done;
+	stats.total = total;
+	stats.elapsed_seconds =
+			std::chrono::duration<double>(now - start_time).count();
+	if (progress_callback) {
+		progress_callback(phase, done, total);
+	}
+	if (cancellation_token && *cancellation_token) {
+		stats.stopped = true;
+		throw "retiming cancelled.";
+	}
+	if (time_budget.count() > 0 && now > deadline) {
+		stats.stopped = true;
+		throw "retiming time budget exceeded.";
+	}
 }
 
 void RetimingManager::move_weights(std::vector<int> &pc_distances) {
+	row_cache.clear();
 	boost::property_map<Graph, boost::vertex_index_t>::type vertex_id =
 			boost::get(boost::vertex_index, *main_graph);
 	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
@@ -309,38 +1082,300 @@ void RetimingManager::move_weights(std::vector<int> &pc_distances) {
 	}
 }
 
+/**
+ * Edge predicate that hides the edges entering the source node
+ */
+struct NotToSource {
+	NotToSource() :
+			graph(nullptr) {
+	}
+	explicit NotToSource(const Graph *graph) :
+			graph(graph) {
+	}
+	template<typename E>
+	bool operator()(const E &e) const {
+		return boost::target(e, *graph) != SOURCE;
+	}
+	const Graph *graph;
+};
+
+bool RetimingManager::is_back_edge(int u, int v) const {
+	if (v == SOURCE) {
+		return true;
+	}
+	if (loop_component[u] != loop_component[v]) {
+		return false;
+	}
+	if (program_ordered[loop_component[u]]) {
+		return v <= u;
+	}
+	// v is an ancestor of u (or u itself) in the depth first search tree
+	return discover_time[v] <= discover_time[u]
+			&& finish_time[u] <= finish_time[v];
+}
+
+void RetimingManager::build_topological_order() {
+	const unsigned int num_vertices = boost::num_vertices(*main_graph);
+	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
+	typename GraphTraits::out_edge_iterator out_i, out_end;
+
+	// loops are the strongly connected components once the edges that go
+	// back to the entry node are removed
+	loop_component.assign(num_vertices, 0);
+	int num_loops = 0;
+	if (num_vertices > 0) {
+		boost::filtered_graph<Graph, NotToSource> no_source_loops(*main_graph,
+				NotToSource(main_graph.get()));
+		num_loops = boost::strong_components(no_source_loops,
+				&loop_component[0]);
+	}
+
+	/*
+	 * Iterative depth first search from the source: an edge that reaches a
+	 * vertex still on the stack closes a loop, whatever the numbering of
+	 * its vertices. The vertices that are not reachable keep time -1.
+	 */
+	discover_time.assign(num_vertices, -1);
+	finish_time.assign(num_vertices, -1);
+	int time = 0;
+	unsigned int num_reachable = 0;
+	std::vector<std::pair<int, typename GraphTraits::out_edge_iterator> > stack;
+	if (num_vertices > 0) {
+		discover_time[SOURCE] = time++;
+		num_reachable++;
+		stack.push_back(
+				std::make_pair(SOURCE,
+						boost::out_edges(SOURCE, *main_graph).first));
+	}
+	while (!stack.empty()) {
+		const int u = stack.back().first;
+		if (stack.back().second == boost::out_edges(u, *main_graph).second) {
+			finish_time[u] = time++;
+			stack.pop_back();
+			continue;
+		}
+		const int v = index[boost::target(*stack.back().second++, *main_graph)];
+		if (discover_time[v] == -1) {
+			discover_time[v] = time++;
+			num_reachable++;
+			stack.push_back(
+					std::make_pair(v, boost::out_edges(v, *main_graph).first));
+		}
+	}
+
+	/*
+	 * A loop is program ordered if each of its reachable vertices has an
+	 * incoming edge from another loop or from a previous operation; else
+	 * the loop is entered above its lowest vertex, or some operation is
+	 * reached only by going back, and the depth first search decides.
+	 */
+	std::vector<bool> forward_reached(num_vertices, false);
+	for (unsigned int u = 0; u < num_vertices; u++) {
+		if (discover_time[u] == -1) {
+			continue;
+		}
+		for (boost::tie(out_i, out_end) = boost::out_edges(u, *main_graph);
+				out_i != out_end; ++out_i) {
+			const int v = index[boost::target(*out_i, *main_graph)];
+			if (loop_component[u] != loop_component[v] || (int) u < v) {
+				forward_reached[v] = true;
+			}
+		}
+	}
+	program_ordered.assign(num_loops, true);
+	for (unsigned int v = 0; v < num_vertices; v++) {
+		if (v != SOURCE && discover_time[v] != -1 && !forward_reached[v]) {
+			program_ordered[loop_component[v]] = false;
+		}
+	}
+
+	// Kahn's algorithm on the reachable vertices, ignoring back edges
+	std::vector<int> in_degree(num_vertices, 0);
+	for (unsigned int u = 0; u < num_vertices; u++) {
+		if (discover_time[u] == -1) {
+			continue;
+		}
+		for (boost::tie(out_i, out_end) = boost::out_edges(u, *main_graph);
+				out_i != out_end; ++out_i) {
+			const int v = index[boost::target(*out_i, *main_graph)];
+			if (!is_back_edge(u, v)) {
+				in_degree[v]++;
+			}
+		}
+	}
+	topological_order.clear();
+	topological_order.reserve(num_reachable);
+	if (num_vertices > 0) {
+		topological_order.push_back(SOURCE);
+	}
+	for (unsigned int k = 0; k < topological_order.size(); k++) {
+		const int u = topological_order[k];
+		for (boost::tie(out_i, out_end) = boost::out_edges(u, *main_graph);
+				out_i != out_end; ++out_i) {
+			const int v = index[boost::target(*out_i, *main_graph)];
+			if (!is_back_edge(u, v) && --in_degree[v] == 0) {
+				topological_order.push_back(v);
+			}
+		}
+	}
+	if (topological_order.size() != num_reachable) {
+		throw "some reachable vertices are missing from the topological order.";
+	}
+}
+
 std::vector<int> RetimingManager::get_scheduling() const {
-	std::vector<bool> visited(num_vertices(*main_graph), false);
+	std::vector<int> parallelism_profile;
+	return get_scheduling(parallelism_profile);
+}
+
+std::vector<int> RetimingManager::get_scheduling(
+		std::vector<int> &parallelism_profile) const {
 	const weights_map weights = get(boost::edge_weight, *main_graph);
-	typename GraphTraits::out_edge_iterator out_i, out_end;
-	typename GraphTraits::edge_descriptor e;
-	Vertex targ;
-	std::vector<int> scheduling(num_vertices(*main_graph));
 	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
+	typename GraphTraits::out_edge_iterator out_i, out_end;
+	std::vector<int> scheduling(num_vertices(*main_graph), 0);
 
-	// To get the scheduling I do a bfs visit
-	std::list<int> q;
-	scheduling[SOURCE] = delays[0];
-	visited[SOURCE] = true;
-	q.push_back(SOURCE);
-	while (!q.empty()) {
-		int u = q.front();
-		q.pop_front();
+	// ASAP scheduling: visiting the vertices in topological order, all the
+	// predecessors of a vertex are final before the vertex itself is visited
+	if (!topological_order.empty()) {
+		scheduling[SOURCE] = delays[0];
+	}
+	std::vector<bool> reached(num_vertices(*main_graph), false);
+	for (unsigned int k = 0; k < topological_order.size(); k++) {
+		const int u = topological_order[k];
 		for (boost::tie(out_i, out_end) = boost::out_edges(u, *main_graph);
 				out_i != out_end; ++out_i) {
-			e = *out_i;
-			targ = boost::target(e, *main_graph);
-			int v = index[targ];
-			if (!visited[v]) {
-				visited[v] = true;
-				scheduling[v] = scheduling[u] + boost::get(weights, e);
-				q.push_back(v);
+			const int v = index[boost::target(*out_i, *main_graph)];
+			if (is_back_edge(u, v)) {
+				continue;
+			}
+			const int step = scheduling[u] + boost::get(weights, *out_i);
+			if (!reached[v] || step > scheduling[v]) {
+				scheduling[v] = step;
+				reached[v] = true;
 			}
 		}
 	}
+
+	parallelism_profile.clear();
+	for (unsigned int k = 0; k < topological_order.size(); k++) {
+		const int v = topological_order[k];
+		if (scheduling[v] >= (int) parallelism_profile.size()) {
+			parallelism_profile.resize(scheduling[v] + 1, 0);
+		}
+		parallelism_profile[scheduling[v]]++;
+	}
 	return scheduling;
 }
 
+int RetimingManager::compute_clock_period(
+		std::vector<int> &critical_path) const {
+	const unsigned int num_vertices = boost::num_vertices(*main_graph);
+	const weights_map weights = get(boost::edge_weight, *main_graph);
+	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
+	typename GraphTraits::out_edge_iterator out_i, out_end;
+
+	// count the incoming edges without flip flops of each vertex
+	std::vector<int> in_degree(num_vertices, 0);
+	unsigned int u;
+	for (u = 0; u < num_vertices; u++) {
+		for (boost::tie(out_i, out_end) = boost::out_edges(u, *main_graph);
+				out_i != out_end; ++out_i) {
+			if (boost::get(weights, *out_i) == 0) {
+				in_degree[index[boost::target(*out_i, *main_graph)]]++;
+			}
+		}
+	}
+
+	/*
+	 * arrival[v] is the largest delay of a path without flip flops that
+	 * ends in v (delay of v included), pred[v] is the previous vertex in
+	 * that path. The vector order is used as the queue of Kahn's algorithm.
+	 */
+	std::vector<int> arrival(delays.begin(), delays.end());
+	std::vector<int> pred(num_vertices, -1);
+	std::vector<int> order;
+	order.reserve(num_vertices);
+	for (u = 0; u < num_vertices; u++) {
+		if (in_degree[u] == 0) {
+			order.push_back(u);
+		}
+	}
+	for (unsigned int k = 0; k < order.size(); k++) {
+		const int v = order[k];
+		for (boost::tie(out_i, out_end) = boost::out_edges(v, *main_graph);
+				out_i != out_end; ++out_i) {
+			if (boost::get(weights, *out_i) != 0) {
+				continue;
+			}
+			const int t = index[boost::target(*out_i, *main_graph)];
+			if (arrival[v] + delays[t] > arrival[t]) {
+				arrival[t] = arrival[v] + delays[t];
+				pred[t] = v;
+			}
+			if (--in_degree[t] == 0) {
+				order.push_back(t);
+			}
+		}
+	}
+	if (order.size() != num_vertices) {
+		throw "graph contains cycles without flip flops, clock period is unbounded.";
+	}
+
+	critical_path.clear();
+	if (num_vertices == 0) {
+		return 0;
+	}
+	int last = std::max_element(arrival.begin(), arrival.end())
+			- arrival.begin();
+	for (int v = last; v != -1; v = pred[v]) {
+		critical_path.push_back(v);
+	}
+	std::reverse(critical_path.begin(), critical_path.end());
+	return arrival[last];
+}
+
+int RetimingManager::compute_clock_period() const {
+	std::vector<int> critical_path;
+	return compute_clock_period(critical_path);
+}
+
+int RetimingManager::get_input_clock_period() const {
+	return input_clock_period;
+}
+
+int RetimingManager::get_achieved_clock_period() const {
+	return achieved_clock_period;
+}
+
+std::vector<Edge> RetimingManager::get_edges() const {
+	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
+	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
+	std::vector<Edge> result;
+	for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+			++ei) {
+		result.push_back(
+				Edge(index[boost::source(*ei, *main_graph)],
+						index[boost::target(*ei, *main_graph)]));
+	}
+	return result;
+}
+
+const std::vector<int> &RetimingManager::get_delays() const {
+	return delays;
+}
+
+std::vector<int> RetimingManager::get_weights() const {
+	const weights_map weights = get(boost::edge_weight, *main_graph);
+	boost::graph_traits<Graph>::edge_iterator ei, ei_end;
+	std::vector<int> result;
+	for (boost::tie(ei, ei_end) = boost::edges(*main_graph); ei != ei_end;
+			++ei) {
+		result.push_back(boost::get(weights, *ei));
+	}
+	return result;
+}
+
 void RetimingManager::write_main_graph(std::string filename) const {
 	const weights_map weights = get(boost::edge_weight, *main_graph);
 	boost::property_map<Graph, boost::vertex_index_t>::type vertex_id =
@@ -365,8 +1400,8 @@ void RetimingManager::write_main_graph(std::string filename) const {
 	myfile.close();
 }
 
-bool RetimingManager::is_main_graph_cyclic_util(int v, bool visited[],
-		bool *recStack) {
+bool RetimingManager::is_main_graph_cyclic_util(int v,
+		std::vector<bool> &visited, std::vector<bool> &recStack) {
 	const IndexMap index = boost::get(boost::vertex_index, *main_graph);
 	const weights_map weights = get(boost::edge_weight, *main_graph);
 
@@ -407,12 +1442,8 @@ bool RetimingManager::is_main_graph_cyclic_util(int v, bool visited[],
 bool RetimingManager::is_main_graph_cyclic() {
 	// Mark all the vertices as not visited and not part of recursion stack
 	int num_vertices = boost::num_vertices(*main_graph);
-	bool *visited = new bool[num_vertices];
-	bool *recStack = new bool[num_vertices];
-	for (int i = 0; i < num_vertices; i++) {
-		visited[i] = false;
-		recStack[i] = false;
-	}
+	std::vector<bool> visited(num_vertices, false);
+	std::vector<bool> recStack(num_vertices, false);
 
 	// Call the recursive helper function to detect cycle in different DFS trees
 	for (int i = 0; i < num_vertices; i++)
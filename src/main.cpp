@@ -1,13 +1,23 @@
+#include <algorithm>
+#include <dirent.h>
+#include <future>
 #include <iostream>
+#include <iomanip>
+#include <memory>
 #include <string>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "RetimingManager.h"
+#include "EngineHarness.h"
 
 #define DEFAULT_INPUT_FILEPATH "input/example1.txt"
 #define DEFAULT_CONTROL_STEPS 1
 #define DEFAULT_CLOCK_PERIOD 4
 #define DEFAULT_OUTPUT_DIR "output/"
+#define DEFAULT_INPUT_DIR "input/"
+#define HARNESS_SEED 1
+#define PROGRESS_BAR_WIDTH 40
 
 /**
  * it creates a directory with the given name if it does not exist
@@ -46,22 +56,114 @@ std::string get_directory(std::string const & path) {
 	return path.substr(0, path.find_last_of("/\\"));
 }
 
+/**
+ * the phase shown by the progress bar, nullptr if no bar is shown
+ */
+const char *progress_phase = nullptr;
+
+/**
+ * the percentage shown by the progress bar
+ */
+int progress_percentage = -1;
+
+/**
+ * end the line of the current progress bar, if any
+ */
+void end_progress_bar() {
+	if (progress_phase != nullptr) {
+		std::cerr << std::endl;
+		progress_phase = nullptr;
+	}
+}
+
+/**
+ * draw a progress bar in the standard error, redrawing it only when the
+ * percentage or the phase changes
+ * @param phase the name of the current phase
+ * @param done the number of steps of the phase done
+ * @param total the total number of steps of the phase
+ */
+void print_progress_bar(const char *phase, unsigned int done,
+		unsigned int total) {
+	const int percentage = total == 0 ? 100 : 100.0 * done / total;
+	if (phase == progress_phase && percentage == progress_percentage) {
+		return;
+	}
+	if (phase != progress_phase) {
+		end_progress_bar();
+	}
+	progress_phase = phase;
+	progress_percentage = percentage;
+	const int filled = PROGRESS_BAR_WIDTH * percentage / 100;
+	std::cerr << "\r" << std::left << std::setw(18) << phase << " ["
+			<< std::string(filled, '#')
+			<< std::string(PROGRESS_BAR_WIDTH - filled, ' ') << "] "
+			<< std::right << std::setw(3) << percentage << "%" << std::flush;
+}
+
+/**
+ * compare all the retiming engines on the graph input files of
+ * DEFAULT_INPUT_DIR and on random graphs, printing the differences and the
+ * runtime of each engine. The failing random graphs are written in
+ * DEFAULT_OUTPUT_DIR.
+ * @param random_graphs the number of random graphs
+ * @return 0 if all the engines agree, else -1
+ */
+int compare_engines(unsigned int random_graphs) {
+	create_dir_if_do_not_exists(DEFAULT_OUTPUT_DIR);
+	EngineHarness harness(DEFAULT_OUTPUT_DIR);
+
+	std::vector<std::string> input_files;
+	DIR *dir = opendir(DEFAULT_INPUT_DIR);
+	if (dir != nullptr) {
+		struct dirent *entry;
+		while ((entry = readdir(dir)) != nullptr) {
+			if (entry->d_name[0] != '.') {
+				input_files.push_back(
+						std::string(DEFAULT_INPUT_DIR) + entry->d_name);
+			}
+		}
+		closedir(dir);
+	}
+	std::sort(input_files.begin(), input_files.end());
+	for (auto filename : input_files) {
+		harness.run_input_file(filename);
+	}
+	harness.run_random(random_graphs, HARNESS_SEED);
+	harness.print_report();
+	return harness.get_failures() == 0 ? 0 : -1;
+}
+
 int main(int argc, char *argv[]) {
 	/*
-	 * argv[1] = input_filename
-	 * argv[2] = control_steps
-	 * argv[3] = clock_period
-	 * argv[4] = output_path (optional)
+	 * args[0] = input_filename
+	 * args[1] = control_steps
+	 * args[2] = clock_period
+	 * args[3] = output_path (optional)
+	 * --timeout seconds (optional, in any position)
+	 * --compare-engines random_graphs (alone)
 	 */
+	std::vector<std::string> args;
+	double timeout = 0;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--timeout" && i + 1 < argc) {
+			timeout = std::stod(argv[++i]);
+		} else if (std::string(argv[i]) == "--compare-engines" && i + 1 < argc) {
+			return compare_engines(std::stoi(argv[++i]));
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+
 	std::string input_filepath;
 	std::string output_filepath;
 	int control_steps;
 	int clock_period;
 
-	if (argc == 4 || argc == 5) {
-		input_filepath = argv[1];
-		control_steps = std::stoi(argv[2]);
-		clock_period = std::stoi(argv[3]);
+	if (args.size() == 3 || args.size() == 4) {
+		input_filepath = args[0];
+		control_steps = std::stoi(args[1]);
+		clock_period = std::stoi(args[2]);
 	} else {
 		input_filepath = DEFAULT_INPUT_FILEPATH;
 		control_steps = DEFAULT_CONTROL_STEPS;
@@ -70,8 +172,8 @@ int main(int argc, char *argv[]) {
 
 	std::string input_filename = base_name(input_filepath);
 
-	if (argc == 5) {
-		output_filepath = argv[4];
+	if (args.size() == 4) {
+		output_filepath = args[3];
 	} else {
 		output_filepath = DEFAULT_OUTPUT_DIR + input_filename;
 	}
@@ -83,13 +185,64 @@ int main(int argc, char *argv[]) {
 	std::cout << "control steps: " << control_steps << std::endl;
 	std::cout << "clock period: " << clock_period << std::endl;
 
-	RetimingManager rm(input_filepath, control_steps, clock_period);
+	std::unique_ptr<RetimingManager> input;
+	try {
+		input.reset(
+				new RetimingManager(input_filepath, control_steps,
+						clock_period));
+	} catch (const char* msg) {
+		std::cerr << msg << std::endl;
+		return -1;
+	}
+	RetimingManager rm(std::move(*input));
+	if (timeout > 0) {
+		rm.set_time_budget(
+				std::chrono::milliseconds((long long) (timeout * 1000)));
+	}
+	if (isatty(STDERR_FILENO)) {
+		rm.set_progress_callback(print_progress_bar);
+	}
 	try {
 		rm.apply_retiming();
+		end_progress_bar();
 	} catch (const char* msg) {
+		end_progress_bar();
 		std::cerr << msg << std::endl;
+		const RetimingStats stats = rm.get_stats();
+		if (stats.stopped) {
+			std::cerr << "stopped in phase " << stats.phase << " at step "
+					<< stats.done << " of " << stats.total << " after "
+					<< stats.elapsed_seconds << " s" << std::endl;
+		}
 		return -1;
 	}
+
+	/*
+	 * from now on the retimed graph is only read, so the output file and the
+	 * scheduling are produced while the results are printed
+	 */
+	create_dir_if_do_not_exists(output_dir);
+	std::future<void> written = std::async(std::launch::async,
+			[&]() {rm.write_main_graph(output_filepath);});
+	std::vector<int> parallelism_profile;
+	std::future<std::vector<int> > scheduling = std::async(
+			std::launch::async,
+			[&]() {return rm.get_scheduling(parallelism_profile);});
+
+	std::cout << "input clock period: " << rm.get_input_clock_period()
+			<< std::endl;
+	// when the flip flops have not been moved there is nothing achieved
+	if (rm.get_stats().completed) {
+		std::vector<int> critical_path;
+		rm.compute_clock_period(critical_path);
+		std::cout << "achieved clock period: "
+				<< rm.get_achieved_clock_period() << std::endl;
+		std::cout << "critical path: ";
+		for (auto v : critical_path) {
+			std::cout << v << " ";
+		}
+		std::cout << std::endl;
+	}
 	rm.print_main_graph();
 	std::cout << "w matrix:" << std::endl;
 	rm.get_w_matrix().print_matrix();
@@ -98,11 +251,14 @@ int main(int argc, char *argv[]) {
 	std::cout << "pc matrix:" << std::endl;
 	rm.get_pc_matrix().print_matrix();
 
-	create_dir_if_do_not_exists(output_dir);
-
-	rm.write_main_graph(output_filepath);
+	written.get();
 	std::cout << "scheduling: ";
-	for (auto i : rm.get_scheduling()) {
+	for (auto i : scheduling.get()) {
+		std::cout << i << " ";
+	}
+	std::cout << std::endl;
+	std::cout << "operations per step: ";
+	for (auto i : parallelism_profile) {
 		std::cout << i << " ";
 	}
 	std::cout << std::endl;